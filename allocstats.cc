@@ -0,0 +1,18 @@
+/* File: allocstats.cc
+ * -------------------
+ * The counters. The replacement operator new that feeds them is in
+ * countednew.cc.
+ */
+
+#include "allocstats.h"
+
+static thread_local AllocStats counts;
+
+AllocStats GetAllocStats() {
+    return counts;
+}
+
+void CountAllocation(size_t bytes) {
+    counts.count++;
+    counts.bytes += bytes;
+}
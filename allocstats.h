@@ -0,0 +1,40 @@
+/* File: allocstats.h
+ * ------------------
+ * Counts of heap allocations, so -d allocstats can show what each phase
+ * of a compilation allocates. In glc every call of the global operator
+ * new is counted (see countednew.cc), and so is every block an Arena
+ * takes from malloc (the arena's own bump allocations are not heap
+ * allocations and are not counted). The counts are kept per thread, so
+ * a phase measured on one thread is not muddled by work on another.
+ */
+
+#ifndef _H_allocstats
+#define _H_allocstats
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct AllocStats
+{
+    uint64_t count;
+    uint64_t bytes;
+};
+
+inline AllocStats operator-(AllocStats a, AllocStats b) {
+    AllocStats d = { a.count - b.count, a.bytes - b.bytes };
+    return d;
+}
+
+inline AllocStats &operator+=(AllocStats &a, AllocStats b) {
+    a.count += b.count;
+    a.bytes += b.bytes;
+    return a;
+}
+
+// The allocations made on the calling thread so far
+AllocStats GetAllocStats();
+
+// Counts an allocation that doesn't go through operator new
+void CountAllocation(size_t bytes);
+
+#endif
@@ -0,0 +1,93 @@
+/* File: arena.cc
+ * --------------
+ * Implementation of the bump allocator.
+ */
+
+#include "arena.h"
+#include "utility.h"
+#include "allocstats.h"
+#include <stdlib.h>
+
+static thread_local Arena *currentArena = NULL;
+
+Arena::Arena() {
+    blocks = NULL;
+    next = limit = NULL;
+    bytesUsed = 0;
+}
+
+Arena::~Arena() {
+    Release();
+}
+
+/* Starts a new block, big enough for the request even if that is more
+ * than the usual block size. The header is padded out to the alignment
+ * so the space after it is aligned as malloc's result is.
+ */
+void *Arena::AllocateSlow(size_t size) {
+    const size_t header = HeaderSize();
+    size_t usable = (size > BlockSize ? size : BlockSize);
+    Block *b = (Block *)malloc(header + usable);
+    if (!b) Failure("Out of memory");
+    CountAllocation(header + usable);
+    b->next = blocks;
+    b->size = usable;
+    blocks = b;
+    next = (char *)b + header;
+    limit = next + usable;
+
+    void *p = next;
+    next += size;
+    bytesUsed += size;
+    return p;
+}
+
+void Arena::Release() {
+    while (blocks) {
+        Block *b = blocks;
+        blocks = b->next;
+        free(b);
+    }
+    next = limit = NULL;
+    bytesUsed = 0;
+}
+
+void Arena::Rewind() {
+    if (!blocks) return;
+    Block *keep = blocks;
+    blocks = keep->next;
+    Release();
+    keep->next = NULL;
+    blocks = keep;
+    next = (char *)keep + HeaderSize();
+    limit = next + keep->size;
+}
+
+/* Frees the blocks started since the mark was taken. Going back to before
+ * anything was allocated keeps the oldest block, as Rewind() keeps one.
+ */
+void Arena::RewindTo(const Mark &mark) {
+    Block *keep = (Block *)mark.block;
+    while (blocks != keep && (keep != NULL || blocks->next != NULL)) {
+        Block *b = blocks;
+        blocks = b->next;
+        free(b);
+    }
+    if (!blocks) return;
+    next = (keep ? mark.next : (char *)blocks + HeaderSize());
+    limit = (char *)blocks + HeaderSize() + blocks->size;
+    bytesUsed = mark.bytesUsed;
+}
+
+Arena *Arena::Current() {
+    return currentArena;
+}
+
+ArenaScope::ArenaScope(Arena *arena) {
+    saved = currentArena;
+    currentArena = arena;
+}
+
+ArenaScope::~ArenaScope() {
+    currentArena = saved;
+}
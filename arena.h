@@ -0,0 +1,130 @@
+/* File: arena.h
+ * -------------
+ * This file defines Arena, a bump allocator for everything built while
+ * compiling one shader: AST nodes, the types made during checking, and
+ * the storage behind their Lists. Allocating is a pointer increment
+ * within a large block, nothing is ever freed individually, and the
+ * whole lot is released in one go when the compilation is over, so a
+ * long-running process that compiles many shaders keeps a flat footprint.
+ *
+ * Node and List allocate from the arena that is current on the calling
+ * thread, which is set for the length of a compilation by an ArenaScope:
+ *
+ *    Arena arena;
+ *    {
+ *        ArenaScope scope(&arena);
+ *        ... parse and check ...
+ *    }
+ *    arena.Release();
+ *
+ * With no arena current (as during static initialization of the built-in
+ * types) they fall back to the ordinary heap.
+ */
+
+#ifndef _H_arena
+#define _H_arena
+
+#include <stddef.h>
+#include <new>
+
+class Arena
+{
+  protected:
+    struct Block {
+        Block *next;
+        size_t size;             // usable bytes following the header
+    };
+    Block *blocks;               // most recent first
+    char *next, *limit;          // free space in the newest block
+    size_t bytesUsed;
+
+    void *AllocateSlow(size_t size);
+    static size_t HeaderSize() { return (sizeof(Block) + Alignment - 1) & ~(Alignment - 1); }
+
+  public:
+    static const size_t BlockSize = 256 * 1024;
+    static const size_t Alignment = alignof(max_align_t);
+
+    Arena();
+    ~Arena();
+
+          // Returns size bytes aligned for any type. Never fails: running
+          // out of memory is reported with Failure().
+    void *Allocate(size_t size) {
+        size = (size + Alignment - 1) & ~(Alignment - 1);
+        if ((size_t)(limit - next) < size) return AllocateSlow(size);
+        void *p = next;
+        next += size;
+        bytesUsed += size;
+        return p;
+    }
+
+          // Frees every block at once. Destructors are not run; nothing
+          // allocated here may own memory from anywhere else.
+    void Release();
+
+          // Frees all but the newest block and empties that one, for an
+          // arena that is filled and emptied over and over
+    void Rewind();
+
+          // A point to go back to with RewindTo(), freeing everything
+          // allocated since; marks are gone back to last taken first
+    struct Mark {
+      void *block;
+      char *next;
+      size_t bytesUsed;
+    };
+    Mark GetMark() const { Mark m = { blocks, next, bytesUsed }; return m; }
+    void RewindTo(const Mark &mark);
+
+    size_t BytesUsed() const { return bytesUsed; }
+
+          // The calling thread's current arena, or NULL
+    static Arena *Current();
+};
+
+/* Class: ArenaScope
+ * -----------------
+ * Makes an arena current on this thread until the scope ends, then puts
+ * back whichever arena was current before.
+ */
+class ArenaScope
+{
+    Arena *saved;
+  public:
+    ArenaScope(Arena *arena);
+    ~ArenaScope();
+};
+
+/* Function: ArenaAllocate()
+ * -------------------------
+ * Allocates from the current arena if there is one, or else the heap.
+ * Memory from here is never given back individually.
+ */
+inline void *ArenaAllocate(size_t size) {
+    Arena *arena = Arena::Current();
+    return arena ? arena->Allocate(size) : ::operator new(size);
+}
+
+/* Class: ArenaAllocator
+ * ---------------------
+ * A standard allocator over ArenaAllocate(), for containers that live in
+ * AST nodes. Deallocation is a no-op: a container that grows leaves its
+ * old storage behind in the arena until the arena is released.
+ */
+template<class T> class ArenaAllocator
+{
+  public:
+    typedef T value_type;
+
+    ArenaAllocator() {}
+    template<class U> ArenaAllocator(const ArenaAllocator<U> &) {}
+
+    T *allocate(size_t n) { return (T *)ArenaAllocate(n * sizeof(T)); }
+    void deallocate(T *, size_t) {}
+
+    template<class U> bool operator==(const ArenaAllocator<U> &) const { return true; }
+    template<class U> bool operator!=(const ArenaAllocator<U> &) const { return false; }
+};
+
+#endif
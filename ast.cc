@@ -5,25 +5,20 @@
 #include "ast.h"
 #include "ast_type.h"
 #include "ast_decl.h"
-#include "symtable.h"
+#include "ast_flat.h"
+#include "scanner.h" // for ExpandRange
 #include <string.h> // strdup
 #include <stdio.h>  // printf
 
-// Global Variables
-SymbolTable *Node::symtable = new SymbolTable();
-std::stack<Type*>* Node::returnTypes = new std::stack<Type*>();
-std::stack<bool>* Node::foundReturn = new std::stack<bool>();
-int Node::loops = 0;
-int Node::switchStmt = 0;
-
-Node::Node(yyltype loc) {
-    location = new yyltype(loc);
+Node::Node(NodeKind kind, SourceRange loc) : nodeKind(kind) {
+    location = loc;
     parent = NULL;
+    row = UINT32_MAX;
 }
 
-Node::Node() {
-    location = NULL;
+Node::Node(NodeKind kind) : nodeKind(kind) {
     parent = NULL;
+    row = UINT32_MAX;
 }
 
 /* The Print method is used to print the parse tree nodes.
@@ -36,20 +31,24 @@ Node::Node() {
  */
 void Node::Print(int indentLevel, const char *label) { 
     const int numSpaces = 3;
-    printf("\n");
-    if (GetLocation()) 
-        printf("%*d", numSpaces, GetLocation()->first_line);
+    fprintf(OutputFile(), "\n");
+    if (location.IsValid())
+        fprintf(OutputFile(), "%*d", numSpaces, ExpandRange(location).first_line);
     else 
-        printf("%*s", numSpaces, "");
-    printf("%*s%s%s: ", indentLevel*numSpaces, "", 
+        fprintf(OutputFile(), "%*s", numSpaces, "");
+    fprintf(OutputFile(), "%*s%s%s: ", indentLevel*numSpaces, "", 
            label? label : "", GetPrintNameForNode());
    PrintChildren(indentLevel);
 } 
 	 
-Identifier::Identifier(yyltype loc, const char *n) : Node(loc) {
-    name = strdup(n);
+Identifier::Identifier(SourceRange loc, const char *n) : Node(NK_Identifier, loc) {
+    name = n;
 } 
 
 void Identifier::PrintChildren(int indentLevel) {
-    printf("%s", name);
+    fprintf(OutputFile(), "%s", name);
+}
+
+void Identifier::FlattenChildren(FlatBuilder *b) {
+    b->Value(name);
 }
@@ -7,10 +7,12 @@
  * more correctly, of instances of concrete subclassses such as VarDecl,
  * ForStmt, and AssignExpr).
  * 
- * Location: Each node maintains its lexical location (line and columns in 
- * file), that location can be NULL for those nodes that don't care/use 
- * locations. The location is typcially set by the node constructor.  The 
- * location is used to provide the context when reporting semantic errors.
+ * Location: Each node maintains its lexical location as a SourceRange, the
+ * offsets of its first and last characters, which is stored in the node
+ * itself and expanded to lines and columns only when it is needed. The
+ * range is invalid for those nodes that don't care/use locations. The
+ * location is typcially set by the node constructor.  The location is
+ * used to provide the context when reporting semantic errors.
  *
  * Parent: Each node has a pointer to its parent. For a Program node, the 
  * parent is NULL, for all other nodes it is the pointer to the node one level
@@ -27,10 +29,18 @@
  * provide already implement these methods, so your job is to construct the
  * nodes and wire them up during parsing. Once that's done, printing is a snap!
 
- * Semantic analysis: For pp3 you are adding "Check" behavior to the ast
- * node classes. Your semantic analyzer should do an inorder walk on the
- * parse tree, and when visiting each node, verify the particular
- * semantic rules that apply to that construct.
+ * Semantic analysis: The checks are not methods of the nodes but passes
+ * (see passes.h and semantic.h) over the flat form of the tree, which
+ * the parser builds alongside this one (see ast_flat.h). Each node knows
+ * its row there; what the passes work out about it, such as the
+ * declaration a name refers to and the type of an expression, is kept
+ * with the row, not in the node.
+ *
+ * Kind: Each node records which concrete class it is as a NodeKind, given
+ * to the constructor. Each class has a static classof() that tests the
+ * kind, so isa<>, cast<> and dyn_cast<> (below) can ask what a node is
+ * without RTTI. The kinds are listed so that the subclasses of each class
+ * form one contiguous range, which classof() tests with two compares.
 
  */
 
@@ -38,36 +48,66 @@
 #define _H_ast
 
 #include <stdlib.h>   // for NULL
+#include <stdint.h>
 #include "location.h"
+#include "arena.h"
+#include "utility.h"
 #include <iostream>
-#include <stack>
 
 using namespace std;
 
-class SymbolTable;
-class MyStack;
-class FnDecl;
 class Type;
+class FlatBuilder;
+
+// One per concrete node class, each class's subclasses right after it
+enum NodeKind {
+    NK_Identifier, NK_Error, NK_Program, NK_Operator, NK_TypeQualifier,
+
+    NK_Type, NK_NamedType, NK_ArrayType,
+
+    NK_VarDecl, NK_VarDeclError,
+    NK_FnDecl, NK_FormalsError,
+
+    NK_StmtBlock, NK_DeclStmt,
+    NK_ForStmt, NK_WhileStmt,                   // LoopStmt
+    NK_IfStmt, NK_IfStmtExprError,              // (with loops) ConditionalStmt
+    NK_BreakStmt, NK_ContinueStmt, NK_ReturnStmt,
+    NK_Case, NK_Default,                        // SwitchLabel
+    NK_SwitchStmt, NK_SwitchStmtError,
+
+    NK_ExprError, NK_EmptyExpr,                 // (and all below) Expr
+    NK_IntConstant, NK_FloatConstant, NK_BoolConstant, NK_VarExpr,
+    NK_ArithmeticExpr, NK_RelationalExpr, NK_EqualityExpr,
+    NK_LogicalExpr, NK_AssignExpr, NK_PostfixExpr, // CompoundExpr
+    NK_ConditionalExpr,
+    NK_ArrayAccess, NK_FieldAccess,             // LValue
+    NK_Call, NK_ActualsError
+};
 
 class Node  {
 
   protected:
-    yyltype *location;
+    SourceRange location;
     Node *parent;
+    const NodeKind nodeKind;
+    uint32_t row;             // in the FlatTree, or UINT32_MAX until it has one
 
   public:
-    static SymbolTable *symtable;
-    static stack<Type*> *returnTypes;
-    static stack<bool> *foundReturn;
-    static int loops;
-    static int switchStmt;
-    Node(yyltype loc);
-    Node();
+    Node(NodeKind kind, SourceRange loc);
+    Node(NodeKind kind);
     virtual ~Node() {}
+
+    // Nodes come from the current arena (see arena.h) and are released
+    // along with it, never one at a time.
+    void *operator new(size_t size) { return ArenaAllocate(size); }
+    void operator delete(void *) {}
     
-    yyltype *GetLocation()   { return location; }
+    NodeKind GetNodeKind() const { return nodeKind; }
+    SourceRange GetLocation() const { return location; }
     void SetParent(Node *p)  { parent = p; }
     Node *GetParent()        { return parent; }
+    uint32_t GetRow() const  { return row; }
+    void SetRow(uint32_t r)  { row = r; }
 
     virtual const char *GetPrintNameForNode() = 0;
     
@@ -76,20 +116,45 @@ class Node  {
     void Print(int indentLevel, const char *label = NULL); 
     virtual void PrintChildren(int indentLevel)  {}
 
-    virtual void Check() {}
+    // Describes the node's children and leaf value to a FlatBuilder, in
+    // the order PrintChildren() prints them (see ast_flat.h)
+    virtual void FlattenChildren(FlatBuilder *b)  {}
 };
+
+/* Function: isa<T>(), cast<T>(), dyn_cast<T>()
+ * --------------------------------------------
+ * isa<T>(n) tells whether n is a T (or a subclass of it); cast<T>(n)
+ * converts n to a T, which it must be; dyn_cast<T>(n) converts n to a T
+ * if it is one, and gives NULL otherwise (or if n is NULL).
+ */
+template<class T> inline bool isa(const Node *n) {
+    return T::classof(n);
+}
+
+template<class T> inline T *cast(Node *n) {
+    Assert(isa<T>(n));
+    return static_cast<T *>(n);
+}
+
+template<class T> inline T *dyn_cast(Node *n) {
+    return n != NULL && isa<T>(n) ? static_cast<T *>(n) : NULL;
+}
    
 
+// Identifier names are interned (see intern.h), so two Identifiers name
+// the same thing exactly when their GetName() pointers are equal.
 class Identifier : public Node 
 {
   protected:
-    char *name;
+    const char *name;
     
   public:
-    Identifier(yyltype loc, const char *name);
+    Identifier(SourceRange loc, const char *name); // name must be interned
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_Identifier; }
     const char *GetPrintNameForNode()   { return "Identifier"; }
-    char *GetName() const { return name; }
+    const char *GetName() const { return name; }
     void PrintChildren(int indentLevel);
+    void FlattenChildren(FlatBuilder *b);
     friend ostream& operator<<(ostream& out, Identifier *id) { return out << id->name; }
 };
 
@@ -102,7 +167,8 @@ class Identifier : public Node
 class Error : public Node
 {
   public:
-    Error() : Node() {}
+    Error() : Node(NK_Error) {}
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_Error; }
     const char *GetPrintNameForNode()   { return "Error"; }
 };
 
@@ -5,101 +5,34 @@
 #include "ast_decl.h"
 #include "ast_type.h"
 #include "ast_stmt.h"
-#include "symtable.h"        
+#include "ast_flat.h"
 
-void VarDecl::Check(){
-	
-	// push this error upstream so we have logic for cascading errors
-	printf("VarDecl Check!\n");
-	
-	bool *typeFlag= new bool; 
-  *typeFlag = false;
-
-	/**** Check for type errors ***************/
-	VarDecl * v = dynamic_cast<VarDecl*>(this);
-	
-	if( v->assignTo != NULL ) {
-	
-		Type * vtype = v->assignTo->getType(typeFlag);
-	
-		if( strcmp (this->type->GetTypeName(), vtype->GetTypeName()) ) {
-			if(*typeFlag == false)
-				ReportError::InvalidInitialization(this->id, this->type, vtype);
-			*typeFlag = true;
-		}
-	}
-
-	/**** check for redeclaration error *******/
-	Symbol *declaration = new Symbol(this->id->GetName(), this, E_VarDecl);
-	int error = symtable->insert(*declaration, typeFlag);
-
-}
-
-void FnDecl::Check() {
-  printf("FuncDecl Check!\n");
-
-	bool *typeFlag = new bool;
-	*typeFlag = false;
-
-	/**** Check for redeclaration errors *****/
-  // function name
-	Symbol *declaration = new Symbol(this->id->GetName(), this, E_FunctionDecl);
-	int error = symtable->insert(*declaration, typeFlag);
-
-	/***** Check for type errors ********************************/
-	FnDecl *f = dynamic_cast<FnDecl*>(this);
-	
-  	/**** Check return types	****/
-	if( f->body != NULL ) {
-		Type* fReturnType = f->GetType();
-
-		Type* voidType = new Type("void");
-		if( !strcmp( fReturnType->GetTypeName(), voidType->GetTypeName() )) {
-      		foundReturn->push(true); // true if it's void
-    	} else {
-      		foundReturn->push(false); // false if return type isn't void
-    	}
-		returnTypes->push(fReturnType);
-	}
-
-  StmtBlock * sb = dynamic_cast<StmtBlock*>(f->body);
-  sb->Check(formals);
-  
-  	/*** Check if return statement is found or not ****/
-  	if( foundReturn->size() > 0 ) {
-		bool found = foundReturn->top();
-		foundReturn->pop();
-		if( found == false ) {
-			ReportError::ReturnMissing(this);
-		}
-	}
-  
-  //returnTypes->pop();
-}
-         
-Decl::Decl(Identifier *n) : Node(*n->GetLocation()) {
+Decl::Decl(NodeKind kind, Identifier *n) : Node(kind, n->GetLocation()) {
     Assert(n != NULL);
     (id=n)->SetParent(this); 
 }
 
-VarDecl::VarDecl(Identifier *n, Type *t, Expr *e) : Decl(n) {
+VarDecl::VarDecl(Identifier *n, Type *t, Expr *e) : Decl(NK_VarDecl, n) {
     Assert(n != NULL && t != NULL);
     (type=t)->SetParent(this);
+    assignTo = NULL;
     if (e) (assignTo=e)->SetParent(this);
     typeq = NULL;
 }
 
-VarDecl::VarDecl(Identifier *n, TypeQualifier *tq, Expr *e) : Decl(n) {
+VarDecl::VarDecl(Identifier *n, TypeQualifier *tq, Expr *e) : Decl(NK_VarDecl, n) {
     Assert(n != NULL && tq != NULL);
     (typeq=tq)->SetParent(this);
+    assignTo = NULL;
     if (e) (assignTo=e)->SetParent(this);
     type = NULL;
 }
 
-VarDecl::VarDecl(Identifier *n, Type *t, TypeQualifier *tq, Expr *e) : Decl(n) {
+VarDecl::VarDecl(Identifier *n, Type *t, TypeQualifier *tq, Expr *e) : Decl(NK_VarDecl, n) {
     Assert(n != NULL && t != NULL && tq != NULL);
     (type=t)->SetParent(this);
     (typeq=tq)->SetParent(this);
+    assignTo = NULL;
     if (e) (assignTo=e)->SetParent(this);
 }
   
@@ -110,7 +43,14 @@ void VarDecl::PrintChildren(int indentLevel) {
    if (assignTo) assignTo->Print(indentLevel+1, "(initializer) ");
 }
 
-FnDecl::FnDecl(Identifier *n, Type *r, List<VarDecl*> *d) : Decl(n) {
+void VarDecl::FlattenChildren(FlatBuilder *b) {
+   b->Child(typeq);
+   b->Child(type);
+   b->Child(id);
+   b->Child(assignTo, "(initializer) ");
+}
+
+FnDecl::FnDecl(Identifier *n, Type *r, List<VarDecl*> *d) : Decl(NK_FnDecl, n) {
     Assert(n != NULL && r!= NULL && d != NULL);
     (returnType=r)->SetParent(this);
     (formals=d)->SetParentAll(this);
@@ -118,7 +58,7 @@ FnDecl::FnDecl(Identifier *n, Type *r, List<VarDecl*> *d) : Decl(n) {
     returnTypeq = NULL;
 }
 
-FnDecl::FnDecl(Identifier *n, Type *r, TypeQualifier *rq, List<VarDecl*> *d) : Decl(n) {
+FnDecl::FnDecl(Identifier *n, Type *r, TypeQualifier *rq, List<VarDecl*> *d) : Decl(NK_FnDecl, n) {
     Assert(n != NULL && r != NULL && rq != NULL&& d != NULL);
     (returnType=r)->SetParent(this);
     (returnTypeq=rq)->SetParent(this);
@@ -137,3 +77,10 @@ void FnDecl::PrintChildren(int indentLevel) {
     if (body) body->Print(indentLevel+1, "(body) ");
 }
 
+void FnDecl::FlattenChildren(FlatBuilder *b) {
+    b->Child(returnType, "(return type) ");
+    b->Child(id);
+    if (formals) b->ChildList(formals, "(formals) ");
+    b->Child(body, "(body) ");
+}
+
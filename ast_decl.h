@@ -31,8 +31,10 @@ class Decl : public Node
     Identifier *id;
   
   public:
-    Decl() : id(NULL) {}
-    Decl(Identifier *name);
+    Decl(NodeKind kind) : Node(kind), id(NULL) {}
+    Decl(NodeKind kind, Identifier *name);
+    static bool classof(const Node *n)
+        { return n->GetNodeKind() >= NK_VarDecl && n->GetNodeKind() <= NK_FormalsError; }
     Identifier *GetIdentifier() const { return id; }
     friend ostream& operator<<(ostream& out, Decl *d) { return out << d->id; }
 
@@ -46,20 +48,24 @@ class VarDecl : public Decl
     Expr *assignTo;
     
   public:
-    void Check();
-    VarDecl() : type(NULL), typeq(NULL), assignTo(NULL) {}
+    VarDecl(NodeKind kind = NK_VarDecl) : Decl(kind), type(NULL), typeq(NULL), assignTo(NULL) {}
     VarDecl(Identifier *name, Type *type, Expr *assignTo = NULL);
     VarDecl(Identifier *name, TypeQualifier *typeq, Expr *assignTo = NULL);
     VarDecl(Identifier *name, Type *type, TypeQualifier *typeq, Expr *assignTo = NULL);
+    static bool classof(const Node *n)
+        { return n->GetNodeKind() >= NK_VarDecl && n->GetNodeKind() <= NK_VarDeclError; }
     const char *GetPrintNameForNode() { return "VarDecl"; }
     void PrintChildren(int indentLevel);
+    void FlattenChildren(FlatBuilder *b);
     Type *GetType() const { return type; }
+    Expr *GetInitializer() const { return assignTo; }
 };
 
 class VarDeclError : public VarDecl
 {
   public:
-    VarDeclError() : VarDecl() { yyerror(this->GetPrintNameForNode()); };
+    VarDeclError() : VarDecl(NK_VarDeclError) { yyerror(this->GetPrintNameForNode()); };
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_VarDeclError; }
     const char *GetPrintNameForNode() { return "VarDeclError"; }
 };
 
@@ -72,22 +78,27 @@ class FnDecl : public Decl
     Stmt *body;
     
   public:
-    void Check();
-    FnDecl() : Decl(), formals(NULL), returnType(NULL), returnTypeq(NULL), body(NULL) {}
+    FnDecl(NodeKind kind = NK_FnDecl)
+        : Decl(kind), formals(NULL), returnType(NULL), returnTypeq(NULL), body(NULL) {}
     FnDecl(Identifier *name, Type *returnType, List<VarDecl*> *formals);
     FnDecl(Identifier *name, Type *returnType, TypeQualifier *returnTypeq, List<VarDecl*> *formals);
+    static bool classof(const Node *n)
+        { return n->GetNodeKind() >= NK_FnDecl && n->GetNodeKind() <= NK_FormalsError; }
     void SetFunctionBody(Stmt *b);
     const char *GetPrintNameForNode() { return "FnDecl"; }
     void PrintChildren(int indentLevel);
+    void FlattenChildren(FlatBuilder *b);
 
     Type *GetType() const { return returnType; }
     List<VarDecl*> *GetFormals() {return formals;}
+    Stmt *GetBody() const { return body; }
 };
 
 class FormalsError : public FnDecl
 {
   public:
-    FormalsError() : FnDecl() { yyerror(this->GetPrintNameForNode()); }
+    FormalsError() : FnDecl(NK_FormalsError) { yyerror(this->GetPrintNameForNode()); }
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_FormalsError; }
     const char *GetPrintNameForNode() { return "FormalsError"; }
 };
 
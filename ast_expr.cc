@@ -7,31 +7,43 @@
 #include "ast_expr.h"
 #include "ast_type.h"
 #include "ast_decl.h"
-#include "symtable.h"
+#include "ast_flat.h"
 
 
-IntConstant::IntConstant(yyltype loc, int val) : Expr(loc) {
+IntConstant::IntConstant(SourceRange loc, int val) : Expr(NK_IntConstant, loc) {
     value = val;
 }
 void IntConstant::PrintChildren(int indentLevel) { 
-    printf("%d", value);
+    fprintf(OutputFile(), "%d", value);
 }
 
-FloatConstant::FloatConstant(yyltype loc, double val) : Expr(loc) {
+void IntConstant::FlattenChildren(FlatBuilder *b) {
+    b->Value(value);
+}
+
+FloatConstant::FloatConstant(SourceRange loc, double val) : Expr(NK_FloatConstant, loc) {
     value = val;
 }
 void FloatConstant::PrintChildren(int indentLevel) { 
-    printf("%g", value);
+    fprintf(OutputFile(), "%g", value);
+}
+
+void FloatConstant::FlattenChildren(FlatBuilder *b) {
+    b->Value(value);
 }
 
-BoolConstant::BoolConstant(yyltype loc, bool val) : Expr(loc) {
+BoolConstant::BoolConstant(SourceRange loc, bool val) : Expr(NK_BoolConstant, loc) {
     value = val;
 }
 void BoolConstant::PrintChildren(int indentLevel) { 
-    printf("%s", value ? "true" : "false");
+    fprintf(OutputFile(), "%s", value ? "true" : "false");
 }
 
-VarExpr::VarExpr(yyltype loc, Identifier *ident) : Expr(loc) {
+void BoolConstant::FlattenChildren(FlatBuilder *b) {
+    b->Value(value);
+}
+
+VarExpr::VarExpr(SourceRange loc, Identifier *ident) : Expr(NK_VarExpr, loc) {
     Assert(ident != NULL);
     this->id = ident;
 }
@@ -40,38 +52,44 @@ void VarExpr::PrintChildren(int indentLevel) {
     id->Print(indentLevel+1);
 }
 
-Operator::Operator(yyltype loc, const char *tok) : Node(loc) {
-    Assert(tok != NULL);
-    strncpy(tokenString, tok, sizeof(tokenString));
+void VarExpr::FlattenChildren(FlatBuilder *b) {
+    b->Child(id);
+}
+
+Operator::Operator(SourceRange loc, OpCode op) : Node(NK_Operator, loc) {
+    Assert(op >= 0 && op < NumOpCodes);
+    opcode = op;
 }
 
 void Operator::PrintChildren(int indentLevel) {
-    printf("%s",tokenString);
+    fprintf(OutputFile(), "%s",OpSpelling(opcode));
 }
 
-bool Operator::IsOp(const char *op) const {
-    return strcmp(tokenString, op) == 0;
+void Operator::FlattenChildren(FlatBuilder *b) {
+    b->Value(opcode);
 }
 
-CompoundExpr::CompoundExpr(Expr *l, Operator *o, Expr *r) 
-  : Expr(Join(l->GetLocation(), r->GetLocation())) {
+
+CompoundExpr::CompoundExpr(NodeKind kind, Expr *l, Operator *o, Expr *r) 
+  : Expr(kind, Join(l->GetLocation(), r->GetLocation())) {
     Assert(l != NULL && o != NULL && r != NULL);
     (op=o)->SetParent(this);
     (left=l)->SetParent(this); 
     (right=r)->SetParent(this);
 }
 
-CompoundExpr::CompoundExpr(Operator *o, Expr *r) 
-  : Expr(Join(o->GetLocation(), r->GetLocation())) {
+CompoundExpr::CompoundExpr(NodeKind kind, Operator *o, Expr *r) 
+  : Expr(kind, Join(o->GetLocation(), r->GetLocation())) {
     Assert(o != NULL && r != NULL);
     left = NULL; 
     (op=o)->SetParent(this);
     (right=r)->SetParent(this);
 }
 
-CompoundExpr::CompoundExpr(Expr *l, Operator *o) 
-  : Expr(Join(l->GetLocation(), o->GetLocation())) {
+CompoundExpr::CompoundExpr(NodeKind kind, Expr *l, Operator *o) 
+  : Expr(kind, Join(l->GetLocation(), o->GetLocation())) {
     Assert(l != NULL && o != NULL);
+    right = NULL;
     (left=l)->SetParent(this);
     (op=o)->SetParent(this);
 }
@@ -81,9 +99,15 @@ void CompoundExpr::PrintChildren(int indentLevel) {
    op->Print(indentLevel+1);
    if (right) right->Print(indentLevel+1);
 }
+
+void CompoundExpr::FlattenChildren(FlatBuilder *b) {
+   b->Child(left);
+   b->Child(op);
+   b->Child(right);
+}
    
 ConditionalExpr::ConditionalExpr(Expr *c, Expr *t, Expr *f)
-  : Expr(Join(c->GetLocation(), f->GetLocation())) {
+  : Expr(NK_ConditionalExpr, Join(c->GetLocation(), f->GetLocation())) {
     Assert(c != NULL && t != NULL && f != NULL);
     (cond=c)->SetParent(this);
     (trueExpr=t)->SetParent(this);
@@ -95,7 +119,13 @@ void ConditionalExpr::PrintChildren(int indentLevel) {
     trueExpr->Print(indentLevel+1, "(true) ");
     falseExpr->Print(indentLevel+1, "(false) ");
 }
-ArrayAccess::ArrayAccess(yyltype loc, Expr *b, Expr *s) : LValue(loc) {
+
+void ConditionalExpr::FlattenChildren(FlatBuilder *b) {
+    b->Child(cond, "(cond) ");
+    b->Child(trueExpr, "(true) ");
+    b->Child(falseExpr, "(false) ");
+}
+ArrayAccess::ArrayAccess(SourceRange loc, Expr *b, Expr *s) : LValue(NK_ArrayAccess, loc) {
     (base=b)->SetParent(this); 
     (subscript=s)->SetParent(this);
 }
@@ -104,9 +134,14 @@ void ArrayAccess::PrintChildren(int indentLevel) {
     base->Print(indentLevel+1);
     subscript->Print(indentLevel+1, "(subscript) ");
 }
+
+void ArrayAccess::FlattenChildren(FlatBuilder *b) {
+    b->Child(base);
+    b->Child(subscript, "(subscript) ");
+}
      
 FieldAccess::FieldAccess(Expr *b, Identifier *f) 
-  : LValue(b? Join(b->GetLocation(), f->GetLocation()) : *f->GetLocation()) {
+  : LValue(NK_FieldAccess, b? Join(b->GetLocation(), f->GetLocation()) : f->GetLocation()) {
     Assert(f != NULL); // b can be be NULL (just means no explicit base)
     base = b; 
     if (base) base->SetParent(this); 
@@ -119,7 +154,12 @@ void FieldAccess::PrintChildren(int indentLevel) {
     field->Print(indentLevel+1);
 }
 
-Call::Call(yyltype loc, Expr *b, Identifier *f, List<Expr*> *a) : Expr(loc)  {
+void FieldAccess::FlattenChildren(FlatBuilder *b) {
+    b->Child(base);
+    b->Child(field);
+}
+
+Call::Call(SourceRange loc, Expr *b, Identifier *f, List<Expr*> *a) : Expr(NK_Call, loc)  {
     Assert(f != NULL && a != NULL); // b can be be NULL (just means no explicit base)
     base = b;
     if (base) base->SetParent(this);
@@ -133,251 +173,8 @@ void Call::PrintChildren(int indentLevel) {
    if (actuals) actuals->PrintAll(indentLevel+1, "(actuals) ");
 }
 
-
-/****************************************************************/
-Type* CompoundExpr::getType(bool *typeError){
-	if(left != NULL && right != NULL){
-		Type* ltype = left->getType(typeError);
-		Type* rtype = right->getType(typeError);
-	
-		if( strcmp(ltype->GetTypeName(), rtype->GetTypeName()) ) {
-			if(*typeError == false)
-				ReportError::IncompatibleOperands(op, ltype, rtype);
-			*typeError = true;
-		}
-		return ltype;
-	}
-	
-	if( left != NULL){
-		Type* ltype = left->getType(typeError);
-		return ltype;
-	}
-
-	if( right != NULL){
-		Type* rtype = right->getType(typeError);
-		return rtype;
-	}
-	cout << "should never get here";
-	return Type::errorType;
-}
-
-Type* ArithmeticExpr::getType(bool *typeError){
-	if( op->IsOp("&&") || op->IsOp("||") ){
-		Type* ltype = left->getType(typeError);
-		Type* rtype = right->getType(typeError);
-
-		if( strcmp(ltype->GetTypeName(),"bool") !=0  ||
-			strcmp(rtype->GetTypeName(),"bool") !=0 ){
-
-			if(*typeError == false)
-				ReportError::IncompatibleOperands(op, ltype, rtype);
-			*typeError = true;
-		}
-		return Type::boolType;
-	}
-
-	if( op->IsOp("==") || op->IsOp("!=") ){
-		Type* ltype = left->getType(typeError);
-		Type* rtype = right->getType(typeError);
-
-		if( strcmp(ltype->GetTypeName(), rtype->GetTypeName()) ) {
-			if(*typeError == false)
-				ReportError::IncompatibleOperands(op, ltype, rtype);
-			*typeError = true;
-		}
-		return Type::boolType;
-	}
-
-	return super::getType(typeError);
-}
-
-Type* VarExpr::getType(bool *typeError){
-	Symbol *found = symtable->find(this->GetIdentifier()->GetName());
-
-	if(found == NULL){
-		if(*typeError == false)
-			ReportError::IdentifierNotDeclared(this->id,LookingForVariable);
-		*typeError = true;
-		return Type::errorType;
-	}
-
-	VarDecl *d = dynamic_cast<VarDecl*>(found->decl);
-	if( d != NULL ){
-		Type* t = d->GetType();
-		return t;
-	}
-	else
-		return Type::errorType;
-}
-
-Type* RelationalExpr::getType(bool *typeError){
-	Type* ltype = left->getType(typeError);
-	Type* rtype = right->getType(typeError);
-
-	if( strcmp(ltype->GetTypeName(), rtype->GetTypeName())!=0 ) {
-		if(*typeError == false)
-			ReportError::IncompatibleOperands(op, ltype, rtype);
-		*typeError = true;
-	}
-	return Type::boolType;
-}
-
-Type* PostfixExpr::getType(bool *typeError){
-	Type* ltype = left->getType(typeError);
-
-	if( !ltype->IsNumeric() ) {
-		if(*typeError == false)
-			ReportError::IncompatibleOperand(op,ltype);
-		*typeError = true;
-	}
-	return ltype;
-}
-
-Type* ConditionalExpr::getType(bool *typeError){
-	Type* condType = cond->getType(typeError);
-	Type* trueType = trueExpr->getType(typeError);
-	Type* falseType = falseExpr->getType(typeError);
-
-	/** not tested so return whatever is fine **/
-	return trueType;
-}
-
-Type* ArrayAccess::getType(bool *typeError){
-	ArrayType* baseType = dynamic_cast<ArrayType*>(base->getType(typeError));
-
-	if( baseType == NULL ){
-		VarExpr *v = dynamic_cast<VarExpr*>(base);
-		if( v != NULL ){
-			if( *typeError == false )
-				ReportError::NotAnArray(v->GetIdentifier());
-			*typeError = true;
-		}
-		return Type::errorType;
-	}
-
-	return baseType->GetElemType();
-}
-
-Type* Call::getType(bool *typeError){
-  Symbol* func = symtable->find(field->GetName());
-
-  if(func != NULL) {
-    /*** Check if it's a function ***/
-    if( func->kind != E_FunctionDecl ) {
-      ReportError::NotAFunction(field);
-      *typeError = true;
-      return Type::errorType;
-    }
-    
-
-    /*** Checking # of arguments ****/
-    int expCount = func->someInfo;
-    int actualCount = actuals->NumElements();
-    if( expCount < actualCount ) {
-      if(*typeError == false)
-        ReportError::ExtraFormals(field, expCount, actualCount);
-      *typeError = true;
-    } else if ( expCount  > actualCount ) {
-      if(*typeError == false)
-        ReportError::LessFormals(field, expCount, actualCount);
-      *typeError = true;
-    }
-    
-    FnDecl *fnd = dynamic_cast<FnDecl*>(func->decl);
-    return fnd->GetType();
-  }
-
-  return Type::errorType;
-  
-}
-Type* FieldAccess::swizzleLengthHelper(int swizLen, bool *typeFlag, Identifier *field, Expr *base){
-	switch(swizLen){
-		case 1:
-			return Type::floatType;
-			break;
-		case 2:
-			return Type::vec2Type;
-			break;
-		case 3:
-			return Type::vec3Type;
-			break;
-		case 4:
-			return Type::vec4Type;
-			break;
-		default:
-			if(*typeFlag == false)
-				ReportError::OversizedVector(field,base);
-			*typeFlag = true;
-			return Type::errorType;
-			break;
-	}
-}
-
-Type* FieldAccess::getType(bool *typeError){
-	Type* ltype;
-	if(base != NULL){
-		ltype = base->getType(typeError);
-		char *swizzle = field->GetName();
-		int swizLen = strlen(swizzle);
-
-		// 2 = vec2, 3 = vec3, 4 = vec4
-		int vNum = 0;
-		//check for invalid swizzles
-		for(int i=0;i<swizLen;i++){
-			switch(swizzle[i]){
-			case 'x':
-				vNum = vNum < 2 ? 2 : vNum;
-				break;
-			case 'y':
-				vNum = vNum < 2 ? 2 : vNum;
-				break;
-			case 'z':
-				vNum = vNum < 3 ? 3 : vNum;
-				break;
-			case 'w':
-				vNum = vNum < 4 ? 4 : vNum;
-				break;
-			default:
-				if(*typeError == false)
-					ReportError::InvalidSwizzle(field,base);
-				*typeError = true;
-				return Type::errorType;
-				break;
-			}
-		}
-
-		//vec2
-		if(strcmp(ltype->GetTypeName(),"vec2")==0){
-			if(vNum > 2 && *typeError == false){
-				ReportError::SwizzleOutOfBound(field,base);
-				*typeError = true;
-				return Type::errorType;
-			}
-			return swizzleLengthHelper(swizLen,typeError,field,base);
-		}
-		//vec3
-		if(strcmp(ltype->GetTypeName(),"vec3")==0){
-			if(vNum > 3 && *typeError == false){
-				ReportError::SwizzleOutOfBound(field,base);
-				*typeError = true;
-				return Type::errorType;
-			}
-			return swizzleLengthHelper(swizLen,typeError,field,base);
-		}
-		//vec4
-		if(strcmp(ltype->GetTypeName(),"vec4")==0){
-			if(vNum > 4 && *typeError == false){
-				ReportError::SwizzleOutOfBound(field,base);
-				*typeError = true;
-				return Type::errorType;
-			}
-			return swizzleLengthHelper(swizLen,typeError,field,base);
-		}
-		
-		if(*typeError == false)
-			ReportError::InaccessibleSwizzle(field,base);
-		*typeError = true;
-		return Type::errorType;
-	}
-	return Type::errorType;
+void Call::FlattenChildren(FlatBuilder *b) {
+   b->Child(base);
+   b->Child(field);
+   if (actuals) b->ChildList(actuals, "(actuals) ");
 }
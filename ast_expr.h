@@ -5,8 +5,8 @@
  * language (add, call, New, etc.) there is a corresponding
  * node class for that construct. 
  *
- * pp3: You will need to extend the Expr classes to implement
- * semantic analysis for rules pertaining to expressions.
+ * The types of expressions are worked out by CheckPass, over the flat
+ * form of the tree (see semantic.h).
  */
 
 
@@ -17,34 +17,24 @@
 #include "ast_stmt.h"
 #include "list.h"
 #include "ast_type.h"
+#include "optypes.h"
 
 void yyerror(const char *msg);
 
 class Expr : public Stmt 
 {
   public:
-    Expr(yyltype loc) : Stmt(loc) {}
-    Expr() : Stmt() {}
-
-    friend std::ostream& operator<< (std::ostream& stream, Expr * expr) {
-        return stream << expr->GetPrintNameForNode();
-    }
-    
-    virtual Type* getType(bool *typeFlag){
-      return Type::errorType;
-    }
-    virtual void Check(){
-      bool *flag = new bool;
-      *flag = false;
-      getType(flag);
-    };
-
+    Expr(NodeKind kind, SourceRange loc) : Stmt(kind, loc) {}
+    Expr(NodeKind kind) : Stmt(kind) {}
+    static bool classof(const Node *n)
+        { return n->GetNodeKind() >= NK_ExprError && n->GetNodeKind() <= NK_ActualsError; }
 };
 
 class ExprError : public Expr
 {
   public:
-    ExprError() : Expr() { yyerror(this->GetPrintNameForNode()); }
+    ExprError() : Expr(NK_ExprError) { yyerror(this->GetPrintNameForNode()); }
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_ExprError; }
     const char *GetPrintNameForNode() { return "ExprError"; }
 };
 
@@ -54,6 +44,8 @@ class ExprError : public Expr
 class EmptyExpr : public Expr
 {
   public:
+    EmptyExpr() : Expr(NK_EmptyExpr) {}
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_EmptyExpr; }
     const char *GetPrintNameForNode() { return "Empty"; }
 };
 
@@ -63,10 +55,11 @@ class IntConstant : public Expr
     int value;
   
   public:
-    IntConstant(yyltype loc, int val);
+    IntConstant(SourceRange loc, int val);
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_IntConstant; }
     const char *GetPrintNameForNode() { return "IntConstant"; }
     void PrintChildren(int indentLevel);
-    Type* getType(bool *typeFlag) { return new Type("int"); }
+    void FlattenChildren(FlatBuilder *b);
 };
 
 class FloatConstant: public Expr 
@@ -75,10 +68,11 @@ class FloatConstant: public Expr
     double value;
     
   public:
-    FloatConstant(yyltype loc, double val);
+    FloatConstant(SourceRange loc, double val);
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_FloatConstant; }
     const char *GetPrintNameForNode() { return "FloatConstant"; }
     void PrintChildren(int indentLevel);
-    Type* getType(bool *typeFlag) { return new Type("float"); }
+    void FlattenChildren(FlatBuilder *b);
 };
 
 class BoolConstant : public Expr 
@@ -87,10 +81,11 @@ class BoolConstant : public Expr
     bool value;
     
   public:
-    BoolConstant(yyltype loc, bool val);
+    BoolConstant(SourceRange loc, bool val);
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_BoolConstant; }
     const char *GetPrintNameForNode() { return "BoolConstant"; }
     void PrintChildren(int indentLevel);
-    Type* getType(bool *typeFlag) { return new Type("bool"); }
+    void FlattenChildren(FlatBuilder *b);
 };
 
 class VarExpr : public Expr
@@ -99,24 +94,27 @@ class VarExpr : public Expr
     Identifier *id;
 
   public:
-    VarExpr(yyltype loc, Identifier *id);
+    VarExpr(SourceRange loc, Identifier *id);
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_VarExpr; }
     const char *GetPrintNameForNode() { return "VarExpr"; }
     void PrintChildren(int indentLevel);
+    void FlattenChildren(FlatBuilder *b);
     Identifier *GetIdentifier() {return id;}
-    Type* getType(bool *typeFlag);
 };
 
 class Operator : public Node 
 {
   protected:
-    char tokenString[4];
+    OpCode opcode;
     
   public:
-    Operator(yyltype loc, const char *tok);
+    Operator(SourceRange loc, OpCode op);
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_Operator; }
+    OpCode GetOpCode() const { return opcode; }
     const char *GetPrintNameForNode() { return "Operator"; }
     void PrintChildren(int indentLevel);
-    friend ostream& operator<<(ostream& out, Operator *o) { return out << o->tokenString; }
-    bool IsOp(const char *op) const;
+    void FlattenChildren(FlatBuilder *b);
+    friend ostream& operator<<(ostream& out, Operator *o) { return out << OpSpelling(o->opcode); }
  };
  
 class CompoundExpr : public Expr
@@ -126,11 +124,15 @@ class CompoundExpr : public Expr
     Expr *left, *right; // left will be NULL if unary
     
   public:
-    CompoundExpr(Expr *lhs, Operator *op, Expr *rhs); // for binary
-    CompoundExpr(Operator *op, Expr *rhs);             // for unary
-    CompoundExpr(Expr *lhs, Operator *op);             // for unary
+    CompoundExpr(NodeKind kind, Expr *lhs, Operator *op, Expr *rhs); // for binary
+    CompoundExpr(NodeKind kind, Operator *op, Expr *rhs);             // for unary
+    CompoundExpr(NodeKind kind, Expr *lhs, Operator *op);             // for unary
+    static bool classof(const Node *n)
+        { return n->GetNodeKind() >= NK_ArithmeticExpr && n->GetNodeKind() <= NK_PostfixExpr; }
     void PrintChildren(int indentLevel);
-    Type* getType(bool *typeFlag);
+    void FlattenChildren(FlatBuilder *b);
+    Expr *GetLeft() { return left; }
+    Expr *GetRight() { return right; }
 };
 
 class ArithmeticExpr : public CompoundExpr 
@@ -139,48 +141,51 @@ class ArithmeticExpr : public CompoundExpr
     typedef CompoundExpr super;
 
   public:
-    ArithmeticExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
-    ArithmeticExpr(Operator *op, Expr *rhs) : CompoundExpr(op,rhs) {}
+    ArithmeticExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(NK_ArithmeticExpr,lhs,op,rhs) {}
+    ArithmeticExpr(Operator *op, Expr *rhs) : CompoundExpr(NK_ArithmeticExpr,op,rhs) {}
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_ArithmeticExpr; }
     const char *GetPrintNameForNode() { return "ArithmeticExpr"; }
-    Type* getType(bool *typeFlag);
 };
 
 class RelationalExpr : public CompoundExpr 
 {
   public:
-    RelationalExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
+    RelationalExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(NK_RelationalExpr,lhs,op,rhs) {}
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_RelationalExpr; }
     const char *GetPrintNameForNode() { return "RelationalExpr"; }
-    Type* getType(bool *typeFlag);
 };
 
 class EqualityExpr : public CompoundExpr 
 {
   public:
-    EqualityExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
+    EqualityExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(NK_EqualityExpr,lhs,op,rhs) {}
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_EqualityExpr; }
     const char *GetPrintNameForNode() { return "EqualityExpr"; }
 };
 
 class LogicalExpr : public CompoundExpr 
 {
   public:
-    LogicalExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
-    LogicalExpr(Operator *op, Expr *rhs) : CompoundExpr(op,rhs) {}
+    LogicalExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(NK_LogicalExpr,lhs,op,rhs) {}
+    LogicalExpr(Operator *op, Expr *rhs) : CompoundExpr(NK_LogicalExpr,op,rhs) {}
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_LogicalExpr; }
     const char *GetPrintNameForNode() { return "LogicalExpr"; }
 };
 
 class AssignExpr : public CompoundExpr 
 {
   public:
-    AssignExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
+    AssignExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(NK_AssignExpr,lhs,op,rhs) {}
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_AssignExpr; }
     const char *GetPrintNameForNode() { return "AssignExpr"; }
 };
 
 class PostfixExpr : public CompoundExpr
 {
   public:
-    PostfixExpr(Expr *lhs, Operator *op) : CompoundExpr(lhs,op) {}
+    PostfixExpr(Expr *lhs, Operator *op) : CompoundExpr(NK_PostfixExpr,lhs,op) {}
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_PostfixExpr; }
     const char *GetPrintNameForNode() { return "PostfixExpr"; }
-    Type* getType(bool *typeFlag);
 
 };
 
@@ -190,15 +195,21 @@ class ConditionalExpr : public Expr
     Expr *cond, *trueExpr, *falseExpr;
   public:
     ConditionalExpr(Expr *c, Expr *t, Expr *f);
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_ConditionalExpr; }
     void PrintChildren(int indentLevel);
+    void FlattenChildren(FlatBuilder *b);
     const char *GetPrintNameForNode() { return "ConditionalExpr"; }
-    Type* getType(bool *typeFlag);
+    Expr *GetCond() { return cond; }
+    Expr *GetTrueExpr() { return trueExpr; }
+    Expr *GetFalseExpr() { return falseExpr; }
 };
 
 class LValue : public Expr 
 {
   public:
-    LValue(yyltype loc) : Expr(loc) {}
+    LValue(NodeKind kind, SourceRange loc) : Expr(kind, loc) {}
+    static bool classof(const Node *n)
+        { return n->GetNodeKind() >= NK_ArrayAccess && n->GetNodeKind() <= NK_FieldAccess; }
 };
 
 class ArrayAccess : public LValue 
@@ -207,10 +218,13 @@ class ArrayAccess : public LValue
     Expr *base, *subscript;
     
   public:
-    ArrayAccess(yyltype loc, Expr *base, Expr *subscript);
+    ArrayAccess(SourceRange loc, Expr *base, Expr *subscript);
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_ArrayAccess; }
     const char *GetPrintNameForNode() { return "ArrayAccess"; }
     void PrintChildren(int indentLevel);
-    Type* getType(bool *typeFlag);
+    void FlattenChildren(FlatBuilder *b);
+    Expr *GetBase() { return base; }
+    Expr *GetSubscript() { return subscript; }
 };
 
 /* Note that field access is used both for qualified names
@@ -226,12 +240,11 @@ class FieldAccess : public LValue
     
   public:
     FieldAccess(Expr *base, Identifier *field); //ok to pass NULL base
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_FieldAccess; }
     const char *GetPrintNameForNode() { return "FieldAccess"; }
     void PrintChildren(int indentLevel);
-    Type* getType(bool *typeFlag);
-
-  private:
-    Type* swizzleLengthHelper(int swizLen, bool *typeFlag, Identifier *field, Expr *base);
+    void FlattenChildren(FlatBuilder *b);
+    Expr *GetBase() { return base; }
 };
 
 /* Like field access, call is used both for qualified base.field()
@@ -246,17 +259,23 @@ class Call : public Expr
     List<Expr*> *actuals;
     
   public:
-    Call() : Expr(), base(NULL), field(NULL), actuals(NULL) {}
-    Call(yyltype loc, Expr *base, Identifier *field, List<Expr*> *args);
+    Call(NodeKind kind = NK_Call) : Expr(kind), base(NULL), field(NULL), actuals(NULL) {}
+    Call(SourceRange loc, Expr *base, Identifier *field, List<Expr*> *args);
+    static bool classof(const Node *n)
+        { return n->GetNodeKind() >= NK_Call && n->GetNodeKind() <= NK_ActualsError; }
     const char *GetPrintNameForNode() { return "Call"; }
     void PrintChildren(int indentLevel);
-    Type* getType(bool * typeFlag);
+    void FlattenChildren(FlatBuilder *b);
+    Expr *GetBase() { return base; }
+    Identifier *GetField() { return field; }
+    List<Expr*> *GetActuals() { return actuals; }
 };
 
 class ActualsError : public Call
 {
   public:
-    ActualsError() : Call() { yyerror(this->GetPrintNameForNode()); }
+    ActualsError() : Call(NK_ActualsError) { yyerror(this->GetPrintNameForNode()); }
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_ActualsError; }
     const char *GetPrintNameForNode() { return "ActualsError"; }
 };
 
@@ -0,0 +1,109 @@
+/* File: ast_flat.cc
+ * -----------------
+ * Building and printing the flat form of the parse tree.
+ */
+
+#include "ast_flat.h"
+#include "ast_type.h"
+#include "scanner.h" // for ExpandRange
+#include <stdio.h>
+
+const FlatTree::Index FlatTree::None;
+
+/* The built-in types and qualifiers are shared by every parse (see
+ * ast_type.h), so they never remember a row: each place one is used gets
+ * a row of its own.
+ */
+static bool IsShared(Node *n) {
+    return (isa<Type>(n) || isa<TypeQualifier>(n)) && !n->GetLocation().IsValid();
+}
+
+/* Has the node report its children, which adds any of them still without
+ * a row, then lays down this node's row with its children as one run at
+ * the end of the children array. The children of the nodes being added
+ * pile up on pending, each node taking its own off the top.
+ */
+FlatTree::Index FlatBuilder::Add(Node *n) {
+    bool shared = IsShared(n);
+    if (!shared && n->GetRow() != FlatTree::None)
+        return n->GetRow();
+
+    size_t base = pending.size();
+    FlatTree::Value outer = value;
+    value.type = NULL;
+    n->FlattenChildren(this);
+
+    FlatTree::Index index = tree->kind.size();
+    tree->kind.push_back(n->GetNodeKind());
+    tree->name.push_back(n->GetPrintNameForNode());
+    tree->label.push_back(NULL);
+    tree->range.push_back(n->GetLocation());
+    tree->parent.push_back(FlatTree::None);
+    tree->firstChild.push_back(tree->children.size());
+    tree->numChildren.push_back(pending.size() - base);
+    tree->value.push_back(value);
+    tree->decl.push_back(FlatTree::None);
+    tree->type.push_back(NULL);
+    tree->typeFailed.push_back(false);
+    for (size_t i = base; i < pending.size(); i++) {
+        tree->children.push_back(pending[i]);
+        if (pending[i] != FlatTree::None)
+            tree->parent[pending[i]] = index;
+    }
+    pending.resize(base);
+    value = outer;
+    if (!shared) n->SetRow(index);
+    return index;
+}
+
+void FlatBuilder::Child(Node *n, const char *label) {
+    FlatTree::Index child = FlatTree::None;
+    if (n != NULL) {
+        child = Add(n);
+        tree->label[child] = label;
+    }
+    pending.push_back(child);
+}
+
+void FlatTree::Print(Index n, int indentLevel) const {
+    const int numSpaces = 3;
+    fprintf(OutputFile(), "\n");
+    if (range[n].IsValid())
+        fprintf(OutputFile(), "%*d", numSpaces, ExpandRange(range[n]).first_line);
+    else
+        fprintf(OutputFile(), "%*s", numSpaces, "");
+    fprintf(OutputFile(), "%*s%s%s: ", indentLevel*numSpaces, "",
+           label[n]? label[n] : "", name[n]);
+    switch (Kind(n)) {
+      case NK_Identifier:
+      case NK_TypeQualifier:
+        fprintf(OutputFile(), "%s", value[n].name);
+        break;
+      case NK_Operator:
+        fprintf(OutputFile(), "%s", OpSpelling(value[n].op));
+        break;
+      case NK_Type:
+        fprintf(OutputFile(), "%s", value[n].type->GetTypeName());
+        break;
+      case NK_IntConstant:
+        fprintf(OutputFile(), "%d", value[n].intValue);
+        break;
+      case NK_FloatConstant:
+        fprintf(OutputFile(), "%g", value[n].floatValue);
+        break;
+      case NK_BoolConstant:
+        fprintf(OutputFile(), "%s", value[n].boolValue ? "true" : "false");
+        break;
+      default:
+        break;
+    }
+    for (Index child : Children(n))
+        if (child != None)
+            Print(child, indentLevel+1);
+}
+
+void FlatTree::Print() const {
+    if (NumNodes() == 0) return;
+    Print(Root(), 0);
+    fprintf(OutputFile(), "\n");
+}
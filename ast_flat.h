@@ -0,0 +1,150 @@
+/* File: ast_flat.h
+ * ----------------
+ * This file defines FlatTree, a second representation of the parse tree
+ * in which the nodes are not objects linked by pointers but rows in a
+ * handful of parallel arrays, one array per field, addressed by 32-bit
+ * indices. A node's children are a contiguous run of indices in a shared
+ * array, so a walk over the tree reads memory mostly in order. The rows
+ * hold only plain values: indices, and pointers to things that outlive
+ * any one tree (interned names, canonical types and string literals).
+ *
+ * The parser builds both trees at once: each grammar action that makes a
+ * node hands it to a FlatBuilder (see Flat() in parser.y), which lays
+ * down its row then and there. So the rows come bottom-up, children
+ * before their parent, in the order the parse finishes the nodes, and
+ * the root is always the last row. The semantic passes run over the flat
+ * tree only (see semantic.h), and keep what they work out about each node
+ * in columns of their own: the declaration a name is bound to and the
+ * type of an expression.
+ *
+ * Each kind of node has its children in the order it prints them, and
+ * an optional child that is absent still takes its place, as None, so
+ * every child sits at a fixed position; after a list, such as a
+ * function's formals, the positions count from the end.
+ *
+ *    VarDecl         qualifier, type, identifier, initializer
+ *    FnDecl          return type, identifier, formals..., body
+ *    ForStmt         init, test, step, body
+ *    IfStmt          test, then, else
+ *    SwitchStmt      expression, cases..., default
+ *    Case, Default   label, statement
+ *    CompoundExpr    left, operator, right
+ *    FieldAccess     base, field
+ *    Call            base, field, actuals...
+ *
+ * The rest are as the class's PrintChildren() has them. A FlatTree
+ * prints exactly like the pointer tree; try it with -d dumpFlat.
+ */
+
+#ifndef _H_ast_flat
+#define _H_ast_flat
+
+#include <stdint.h>
+#include <vector>
+#include "location.h"
+#include "arena.h"
+#include "list.h"
+#include "ast.h"
+#include "optypes.h"
+
+class FlatTree
+{
+  public:
+    typedef uint32_t Index;
+    static const Index None = UINT32_MAX;
+
+    template<class T> using Column = std::vector<T, ArenaAllocator<T> >;
+
+          // What a leaf holds, according to its kind
+    union Value {
+        const char *name;         // Identifier (interned), TypeQualifier
+        OpCode op;                // Operator
+        Type *type;               // Type, NamedType, ArrayType: canonical
+        int intValue;             // IntConstant
+        double floatValue;        // FloatConstant
+        bool boolValue;           // BoolConstant
+    };
+
+          // One entry per node, from the parser
+    Column<uint8_t> kind;           // NodeKind
+    Column<const char *> name;      // GetPrintNameForNode()
+    Column<const char *> label;     // label printed under the parent, or NULL
+    Column<SourceRange> range;
+    Column<Index> parent;           // None for the root
+    Column<Index> firstChild;       // run of numChildren in children
+    Column<uint32_t> numChildren;
+    Column<Value> value;
+
+          // One entry per node, from the passes
+    Column<Index> decl;             // VarExpr, Call: the declaration bound
+                                    // to; Decl: an earlier one it clashes with
+    Column<Type *> type;            // Expr: its type, once asked for
+    Column<uint8_t> typeFailed;     // and whether that found an error
+
+    Column<Index> children;         // None where an optional child is absent
+
+    struct Run {
+        const Index *first, *last;
+        const Index *begin() const { return first; }
+        const Index *end() const { return last; }
+    };
+
+    int NumNodes() const { return kind.size(); }
+    Index Root() const { return kind.size() - 1; }
+    NodeKind Kind(Index n) const { return (NodeKind)kind[n]; }
+    uint32_t NumChildren(Index n) const { return numChildren[n]; }
+    Index Child(Index n, int i) const { return children[firstChild[n] + i]; }
+    Index LastChild(Index n) const { return Child(n, numChildren[n] - 1); }
+
+          // The children of n, less the first skipFirst and last skipLast
+    Run Children(Index n, int skipFirst = 0, int skipLast = 0) const {
+        const Index *run = children.data() + firstChild[n];
+        Run r = { run + skipFirst, run + numChildren[n] - skipLast };
+        return r;
+    }
+
+          // The Identifier row naming a VarDecl or FnDecl
+    Index DeclId(Index decl) const { return Child(decl, Kind(decl) == NK_FnDecl ? 1 : 2); }
+
+          // Prints the subtree at n in the format of Node::Print()
+    void Print(Index n, int indentLevel) const;
+          // Prints the whole tree as Program::Print() does
+    void Print() const;
+};
+
+/* Class: FlatBuilder
+ * ------------------
+ * Lays down the rows of a FlatTree as the parser finishes each node. Add()
+ * has the node describe itself through FlattenChildren(), which calls
+ * back into Child(), ChildList() and Value(). A child made by an earlier
+ * action already has its row; one that doesn't, such as an identifier or
+ * operator made along with its parent or a shared built-in type, gets
+ * one first.
+ */
+class FlatBuilder
+{
+    FlatTree *tree;
+    FlatTree::Column<FlatTree::Index> pending;  // children reported so far,
+                                                // for each node being added
+    FlatTree::Value value;
+
+  public:
+    FlatBuilder(FlatTree *t) : tree(t) { value.type = NULL; }
+
+          // Lays down the row for n, if it hasn't one already, and
+          // returns its index
+    FlatTree::Index Add(Node *n);
+
+    void Child(Node *n, const char *label = NULL);   // n may be NULL
+    template<class Element> void ChildList(List<Element> *list, const char *label = NULL)
+        { for (Element e : *list) Child(e, label); }
+
+    void Value(const char *name)  { value.name = name; }
+    void Value(OpCode op)         { value.op = op; }
+    void Value(Type *type)        { value.type = type; }
+    void Value(int i)             { value.intValue = i; }
+    void Value(double d)          { value.floatValue = d; }
+    void Value(bool b)            { value.boolValue = b; }
+};
+
+#endif
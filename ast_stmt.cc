@@ -7,76 +7,56 @@
 #include "ast_decl.h"
 #include "ast_expr.h"
 #include "errors.h"
-#include "symtable.h"
+#include "symtable.h" // for testSymTables
+#include "intern.h"
+#include "ast_flat.h"
 
-Program::Program(List<Decl*> *d) {
+Program::Program(List<Decl*> *d) : Node(NK_Program) {
     Assert(d != NULL);
     (decls=d)->SetParentAll(this);
 }
 
 void Program::PrintChildren(int indentLevel) {
     decls->PrintAll(indentLevel+1);
-    printf("\n");
+    fprintf(OutputFile(), "\n");
 }
 
-void Program::Check() {
-    /* pp3: here is where the semantic analyzer is kicked off.
-     *      The general idea is perform a tree traversal of the
-     *      entire program, examining all constructs for compliance
-     *      with the semantic rules.  Each node can have its own way of
-     *      checking itself, which makes for a great use of inheritance
-     *      and polymorphism in the node classes.
-     */
-
-    // sample test - not the actual working code
-    // replace it with your own implementation
-    //
-    if ( decls->NumElements() > 0 ) {
-      for ( int i = 0; i < decls->NumElements(); ++i ) {
-        Decl *d = decls->Nth(i);
-        /* !!! YOUR CODE HERE !!!
-         * Basically you have to make sure that each declaration is 
-         * semantically correct.
-         */
-		d->Check();
-      }
-    }
-
-    // test to see if symtables are working (comment out before turning in)
-    //testSymTables();
+void Program::FlattenChildren(FlatBuilder *b) {
+    b->ChildList(decls);
 }
 
 void Program::testSymTables() {
 	printf("=============== symbol table testing ================\n");
-	bool *flag = new bool; *flag = false;
-
-	SymbolTable *testTable = new SymbolTable();
+	SymbolTable table;
+	SymbolTable *testTable = &table;
 	testTable->push(); //push first scopetable
 	testTable->push(); //push second scopetable
 
 	printf("There should be 2 table. Num of tables: ");
-	printf("%zu\n", testTable->tables.size());
+	printf("%zu\n", testTable->NumScopes());
 
 	testTable->pop();
 	printf("Closed a scope. There should be 1 table. Num of tables: ");
-	printf("%zu\n", testTable->tables.size());
+	printf("%zu\n", testTable->NumScopes());
 
-	Symbol *SymbolX = new Symbol((char *)"x", NULL, E_VarDecl, 0);
-	testTable->insert(*SymbolX,flag);
+	Symbol x(Intern("x"), FlatTree::None, E_VarDecl, 0);
+	Symbol *SymbolX = &x;
+	testTable->insert(*SymbolX);
 	printf("Inserted Symbol x\n");
 
-	Symbol *findX = testTable->find((char *)"x");
+	Symbol *findX = testTable->find(Intern("x"));
 	if( findX != NULL )
 		printf("Found Symbol x\n");
 	else
 		printf("Could not find Symbol x\n");
 
 	printf("adding duplicate X, there should be an error: \n");
-	testTable->insert(*SymbolX,flag);
+	if( testTable->insert(*SymbolX) != FlatTree::None )
+		printf("Declaration conflict on x\n");
 
 	printf("opening new scope and finding X\n");
 	testTable->push();
-	Symbol *findX2 = testTable->find((char *)"x");
+	Symbol *findX2 = testTable->find(Intern("x"));
 	if( findX2 != NULL )
 		printf("Found Symbol x\n");
 	else
@@ -88,7 +68,7 @@ void Program::testSymTables() {
 	printf("Removed SymbolX!\n");
 	testTable->pop();
 	testTable->remove(*SymbolX);
-	Symbol *findXX = testTable->find((char *)"x");
+	Symbol *findXX = testTable->find(Intern("x"));
 	if( findXX != NULL)
 		printf("Found Symbol x\n");
 	else
@@ -97,7 +77,7 @@ void Program::testSymTables() {
 	printf("Everything seems to be working. Goodjob Eunice.\n");
 }
 
-StmtBlock::StmtBlock(List<VarDecl*> *d, List<Stmt*> *s) {
+StmtBlock::StmtBlock(List<VarDecl*> *d, List<Stmt*> *s) : Stmt(NK_StmtBlock) {
     Assert(d != NULL && s != NULL);
     (decls=d)->SetParentAll(this);
     (stmts=s)->SetParentAll(this);
@@ -108,7 +88,12 @@ void StmtBlock::PrintChildren(int indentLevel) {
     stmts->PrintAll(indentLevel+1);
 }
 
-DeclStmt::DeclStmt(Decl *d) {
+void StmtBlock::FlattenChildren(FlatBuilder *b) {
+    b->ChildList(decls);
+    b->ChildList(stmts);
+}
+
+DeclStmt::DeclStmt(Decl *d) : Stmt(NK_DeclStmt) {
     Assert(d != NULL);
     (decl=d)->SetParent(this);
 }
@@ -117,13 +102,17 @@ void DeclStmt::PrintChildren(int indentLevel) {
     decl->Print(indentLevel+1);
 }
 
-ConditionalStmt::ConditionalStmt(Expr *t, Stmt *b) { 
+void DeclStmt::FlattenChildren(FlatBuilder *b) {
+    b->Child(decl);
+}
+
+ConditionalStmt::ConditionalStmt(NodeKind kind, Expr *t, Stmt *b) : Stmt(kind) { 
     Assert(t != NULL && b != NULL);
     (test=t)->SetParent(this); 
     (body=b)->SetParent(this);
 }
 
-ForStmt::ForStmt(Expr *i, Expr *t, Expr *s, Stmt *b): LoopStmt(t, b) { 
+ForStmt::ForStmt(Expr *i, Expr *t, Expr *s, Stmt *b): LoopStmt(NK_ForStmt, t, b) { 
     Assert(i != NULL && t != NULL && b != NULL);
     (init=i)->SetParent(this);
     step = s;
@@ -139,12 +128,24 @@ void ForStmt::PrintChildren(int indentLevel) {
     body->Print(indentLevel+1, "(body) ");
 }
 
+void ForStmt::FlattenChildren(FlatBuilder *b) {
+    b->Child(init, "(init) ");
+    b->Child(test, "(test) ");
+    b->Child(step, "(step) ");
+    b->Child(body, "(body) ");
+}
+
 void WhileStmt::PrintChildren(int indentLevel) {
     test->Print(indentLevel+1, "(test) ");
     body->Print(indentLevel+1, "(body) ");
 }
 
-IfStmt::IfStmt(Expr *t, Stmt *tb, Stmt *eb): ConditionalStmt(t, tb) { 
+void WhileStmt::FlattenChildren(FlatBuilder *b) {
+    b->Child(test, "(test) ");
+    b->Child(body, "(body) ");
+}
+
+IfStmt::IfStmt(Expr *t, Stmt *tb, Stmt *eb): ConditionalStmt(NK_IfStmt, t, tb) { 
     Assert(t != NULL && tb != NULL); // else can be NULL
     elseBody = eb;
     if (elseBody) elseBody->SetParent(this);
@@ -156,8 +157,14 @@ void IfStmt::PrintChildren(int indentLevel) {
     if (elseBody) elseBody->Print(indentLevel+1, "(else) ");
 }
 
+void IfStmt::FlattenChildren(FlatBuilder *b) {
+    b->Child(test, "(test) ");
+    b->Child(body, "(then) ");
+    b->Child(elseBody, "(else) ");
+}
+
 
-ReturnStmt::ReturnStmt(yyltype loc, Expr *e) : Stmt(loc) { 
+ReturnStmt::ReturnStmt(SourceRange loc, Expr *e) : Stmt(NK_ReturnStmt, loc) { 
     expr = e;
     if (e != NULL) expr->SetParent(this);
 }
@@ -167,13 +174,17 @@ void ReturnStmt::PrintChildren(int indentLevel) {
       expr->Print(indentLevel+1);
 }
 
-SwitchLabel::SwitchLabel(Expr *l, Stmt *s) {
+void ReturnStmt::FlattenChildren(FlatBuilder *b) {
+    b->Child(expr);
+}
+
+SwitchLabel::SwitchLabel(NodeKind kind, Expr *l, Stmt *s) : Stmt(kind) {
     Assert(l != NULL && s != NULL);
     (label=l)->SetParent(this);
     (stmt=s)->SetParent(this);
 }
 
-SwitchLabel::SwitchLabel(Stmt *s) {
+SwitchLabel::SwitchLabel(NodeKind kind, Stmt *s) : Stmt(kind) {
     Assert(s != NULL);
     label = NULL;
     (stmt=s)->SetParent(this);
@@ -184,7 +195,12 @@ void SwitchLabel::PrintChildren(int indentLevel) {
     if (stmt)  stmt->Print(indentLevel+1);
 }
 
-SwitchStmt::SwitchStmt(Expr *e, List<Stmt *> *c, Default *d) {
+void SwitchLabel::FlattenChildren(FlatBuilder *b) {
+    b->Child(label);
+    b->Child(stmt);
+}
+
+SwitchStmt::SwitchStmt(Expr *e, List<Stmt *> *c, Default *d) : Stmt(NK_SwitchStmt) {
     Assert(e != NULL && c != NULL && c->NumElements() != 0 );
     (expr=e)->SetParent(this);
     (cases=c)->SetParentAll(this);
@@ -198,222 +214,8 @@ void SwitchStmt::PrintChildren(int indentLevel) {
     if (def) def->Print(indentLevel+1);
 }
 
-
-/************************************************************/
-void StmtBlock::Check() {
-	printf("StmtBlock Check!\n");
-	 
-	/** insert new scope **/
-	symtable->push();
-
-	/** go through the list of stmts declarations **/
-
-	if(stmts->NumElements() > 0) {
-		for(int i=0; i < stmts->NumElements(); i++){
-			Stmt* stmt = stmts->Nth(i);
-			stmt->Check();
-		}
-	}
-
-	/** remove current scope **/
-	symtable->pop();
-}
-
-void StmtBlock::Check(List<VarDecl*> *formals) {
-  symtable->push();
-  bool *typeFlag = new bool;
-	*typeFlag = false;
-
-
-  // list of arguments
-  if( formals->NumElements() > 0 ) {
-    for( int i=0; i < formals->NumElements(); i++ ) {
-      VarDecl* var = formals->Nth(i);
-      Symbol * s = new Symbol(var->GetIdentifier()->GetName(), var, E_VarDecl);
-      int err = symtable->insert(*s, typeFlag);
-    }
-  }
-
-  /** go through the list of stmts declarations **/
-	if(stmts->NumElements() > 0) {
-		for(int i=0; i < stmts->NumElements(); i++){
-			Stmt* stmt = stmts->Nth(i);
-			stmt->Check();
-		}
-	}
-
-	/** remove current scope **/
-	symtable->pop();
-
-
-}
-
-void Stmt::Check() {
-	this->Check();
-}
-
-void DeclStmt::Check() {
-	VarDecl * v = dynamic_cast<VarDecl*>(this->decl);
-	v->Check();
-}
-
-void ReturnStmt::Check() {
-	cout << "ReturnStmt Check!" << flush;
-  bool* typeError = new bool;
-	*typeError = false;
-
-  
-	if( foundReturn->top() == false) { // if return type is NOT void
-		foundReturn->pop();
-		foundReturn->push(true); // found return statement
-
-		if(*typeError == false){
-			if( returnTypes->size() > 0 ) {
-	      Type* rType = getType(typeError);
-        
-				Type* cmp = returnTypes->top();
-				if( strcmp( cmp->GetTypeName(), rType->GetTypeName() )) {
-					ReportError::ReturnMismatch(this, rType, cmp);
-					*typeError = true;
-				}
-			}
-		
-		}
-	} else {
-    if( expr != NULL ) {
-    	Type* rType = getType(typeError);
-      ReportError::ReturnMismatch(this, rType, Type::voidType);
-      *typeError = true;
-     }
-  }
-
-}
-
-Type* ReturnStmt::getType(bool * typeError){
-	return expr->getType(typeError) ;
-}
-
-void IfStmt::Check() {
-
-	/** check the type for test **/
-	bool* typeError = new bool;
-	*typeError = false;
-	Type* ifType = test->getType(typeError);
-	if(*typeError == false) {
-		Type* boolType = new Type("bool");
-		if( strcmp( ifType->GetTypeName(), boolType->GetTypeName() )) {
-			ReportError::TestNotBoolean(test);
-			*typeError = true;
-		}
-	}
-	/** check the type for stmt body **/
-	if(body != NULL) body->Check();
-	if(elseBody != NULL) elseBody->Check();
-}
-
-void SwitchStmt::Check() {
-	
-	cout << "SwitchStmt Check!\n" << flush;
-  switchStmt++;
-
-	bool * typeFlag = new bool;
-	*typeFlag = false;
-	//switch test
-	if(expr != NULL) expr->getType(typeFlag);
-	//cases
-	if(cases->NumElements() > 0) {
-		for(int i=0; i < cases->NumElements(); i++){
-			Stmt* switchCase = cases->Nth(i);
-			switchCase->Check();
-		}
-	}
-	// default 
-	if(def != NULL) def->Check();
-  switchStmt--;
-
-}
-
-void Case::Check() {
-	cout << "Case Check!\n" << flush;
-	bool *typeFlag = new bool;
-	*typeFlag = false;
-	if( label != NULL ) label->getType(typeFlag);
-	if( stmt != NULL ) stmt->Check();
-}
-
-void Default::Check() {
-	bool *typeFlag = new bool;
-	*typeFlag = false;
-	if( label != NULL ) label->getType(typeFlag);
-	if( stmt != NULL ) stmt->Check();
-}
-
-
-void WhileStmt::Check(){
-  loops++;
-	/** check the test expr **/
-	bool* typeError = new bool;
-	*typeError = false;
-	Type* whileType = test->getType(typeError);
-	if(*typeError == false){
-		if(strcmp(whileType->GetTypeName(),Type::boolType->GetTypeName()) != 0 ){
-			ReportError::TestNotBoolean(test);
-			*typeError = true;
-		}
-	}
-
-	/** check on stmts in the body **/
-	if(body != NULL) body->Check();
-
-  loops--;
-}
-
-void LoopStmt::Check() {
-	/** test must have boolean type **/
-	bool* typeError = new bool;
-	*typeError = false;
-	Type* testType = test->getType(typeError);
-	if(*typeError == false) {
-		if(strcmp(testType->GetTypeName(), Type::boolType->GetTypeName()) != 0 ){
-			ReportError::TestNotBoolean(test);
-			*typeError = true;
-		}
-	}
-	if( body != NULL ) body->Check();
-}
-
-void ForStmt::Check(){
-  loops++;
-
-	if( init != NULL ) init->Check();
-	bool* typeError = new bool;
-	*typeError = false;
-	Type* testType = test->getType(typeError);
-	if(*typeError == false) {
-		if(strcmp(testType->GetTypeName(), Type::boolType->GetTypeName()) != 0 ){
-			ReportError::TestNotBoolean(test);
-			*typeError = true;
-		}
-	}
-	if( step != NULL ) step->Check();
-	if( body != NULL ) body->Check();
-  loops--;
-}
-
-void BreakStmt::Check() {
-	/* break is only allowed inside a loop */
-  
-  // report error if not in loop and switch
-  if( loops <= 0   && switchStmt <= 0 ) {
-    ReportError::BreakOutsideLoop(this);
-  }
-	return;
-}
-
-void ContinueStmt::Check() {
-  // report error if not in loop
-  if( loops <= 0 ) {
-    ReportError::ContinueOutsideLoop(this);
-  }
-	return;
+void SwitchStmt::FlattenChildren(FlatBuilder *b) {
+    b->Child(expr);
+    if (cases) b->ChildList(cases);
+    b->Child(def);
 }
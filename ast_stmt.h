@@ -31,9 +31,11 @@ class Program : public Node
      
   public:
      Program(List<Decl*> *declList);
+     static bool classof(const Node *n) { return n->GetNodeKind() == NK_Program; }
      const char *GetPrintNameForNode() { return "Program"; }
      void PrintChildren(int indentLevel);
-     virtual void Check();
+     void FlattenChildren(FlatBuilder *b);
+     List<Decl*> *GetDecls() { return decls; }
 
      void testSymTables();
 };
@@ -41,10 +43,10 @@ class Program : public Node
 class Stmt : public Node
 {
   public:
-     void Check();
-     Stmt() : Node() {}
-     Stmt(yyltype loc) : Node(loc) {}
-     virtual Type* getType(bool * typeError) { return new Type("int"); } // must change later
+     Stmt(NodeKind kind) : Node(kind) {}
+     Stmt(NodeKind kind, SourceRange loc) : Node(kind, loc) {}
+     static bool classof(const Node *n)
+         { return n->GetNodeKind() >= NK_StmtBlock && n->GetNodeKind() <= NK_ActualsError; }
 };
 
 class StmtBlock : public Stmt 
@@ -55,10 +57,11 @@ class StmtBlock : public Stmt
     
   public:
     StmtBlock(List<VarDecl*> *variableDeclarations, List<Stmt*> *statements);
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_StmtBlock; }
     const char *GetPrintNameForNode() { return "StmtBlock"; }
     void PrintChildren(int indentLevel);
-    void Check();
-    void Check(List<VarDecl*> *formals);
+    void FlattenChildren(FlatBuilder *b);
+    List<Stmt*> *GetStmts() { return stmts; }
 };
 
 class DeclStmt: public Stmt 
@@ -68,10 +71,11 @@ class DeclStmt: public Stmt
     
   public:
     DeclStmt(Decl *d);
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_DeclStmt; }
     const char *GetPrintNameForNode() { return "DeclStmt"; }
     void PrintChildren(int indentLevel);
-    void Check();
-
+    void FlattenChildren(FlatBuilder *b);
+    Decl *GetDecl() { return decl; }
 };
   
 class ConditionalStmt : public Stmt
@@ -81,17 +85,22 @@ class ConditionalStmt : public Stmt
     Stmt *body;
   
   public:
-    ConditionalStmt() : Stmt(), test(NULL), body(NULL) {}
-    ConditionalStmt(Expr *testExpr, Stmt *body);
+    ConditionalStmt(NodeKind kind) : Stmt(kind), test(NULL), body(NULL) {}
+    ConditionalStmt(NodeKind kind, Expr *testExpr, Stmt *body);
+    static bool classof(const Node *n)
+        { return n->GetNodeKind() >= NK_ForStmt && n->GetNodeKind() <= NK_IfStmtExprError; }
+    Expr *GetTest() { return test; }
+    Stmt *GetBody() { return body; }
 
 };
 
 class LoopStmt : public ConditionalStmt 
 {
   public:
-    LoopStmt(Expr *testExpr, Stmt *body)
-            : ConditionalStmt(testExpr, body) {}
-    void Check();
+    LoopStmt(NodeKind kind, Expr *testExpr, Stmt *body)
+            : ConditionalStmt(kind, testExpr, body) {}
+    static bool classof(const Node *n)
+        { return n->GetNodeKind() >= NK_ForStmt && n->GetNodeKind() <= NK_WhileStmt; }
 };
 
 class ForStmt : public LoopStmt 
@@ -101,19 +110,23 @@ class ForStmt : public LoopStmt
   
   public:
     ForStmt(Expr *init, Expr *test, Expr *step, Stmt *body);
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_ForStmt; }
     const char *GetPrintNameForNode() { return "ForStmt"; }
     void PrintChildren(int indentLevel);
-    void Check();
+    void FlattenChildren(FlatBuilder *b);
+    Expr *GetInit() { return init; }
+    Expr *GetStep() { return step; }
 
 };
 
 class WhileStmt : public LoopStmt 
 {
   public:
-    WhileStmt(Expr *test, Stmt *body) : LoopStmt(test, body) {}
+    WhileStmt(Expr *test, Stmt *body) : LoopStmt(NK_WhileStmt, test, body) {}
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_WhileStmt; }
     const char *GetPrintNameForNode() { return "WhileStmt"; }
     void PrintChildren(int indentLevel);
-    void Check();
+    void FlattenChildren(FlatBuilder *b);
 
 };
 
@@ -123,36 +136,40 @@ class IfStmt : public ConditionalStmt
     Stmt *elseBody;
   
   public:
-    IfStmt() : ConditionalStmt(), elseBody(NULL) {}
+    IfStmt(NodeKind kind = NK_IfStmt) : ConditionalStmt(kind), elseBody(NULL) {}
     IfStmt(Expr *test, Stmt *thenBody, Stmt *elseBody);
+    static bool classof(const Node *n)
+        { return n->GetNodeKind() >= NK_IfStmt && n->GetNodeKind() <= NK_IfStmtExprError; }
     const char *GetPrintNameForNode() { return "IfStmt"; }
     void PrintChildren(int indentLevel);
-    void Check();
+    void FlattenChildren(FlatBuilder *b);
+    Stmt *GetElseBody() { return elseBody; }
 
 };
 
 class IfStmtExprError : public IfStmt
 {
   public:
-    IfStmtExprError() : IfStmt() { yyerror(this->GetPrintNameForNode()); }
+    IfStmtExprError() : IfStmt(NK_IfStmtExprError) { yyerror(this->GetPrintNameForNode()); }
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_IfStmtExprError; }
     const char *GetPrintNameForNode() { return "IfStmtExprError"; }
 };
 
 class BreakStmt : public Stmt 
 {
   public:
-    BreakStmt(yyltype loc) : Stmt(loc) {}
+    BreakStmt(SourceRange loc) : Stmt(NK_BreakStmt, loc) {}
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_BreakStmt; }
     const char *GetPrintNameForNode() { return "BreakStmt"; }
-    void Check();
 
 };
 
 class ContinueStmt : public Stmt 
 {
   public:
-    ContinueStmt(yyltype loc) : Stmt(loc) {}
+    ContinueStmt(SourceRange loc) : Stmt(NK_ContinueStmt, loc) {}
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_ContinueStmt; }
     const char *GetPrintNameForNode() { return "ContinueStmt"; }
-    void Check();
 };
 
 class ReturnStmt : public Stmt  
@@ -161,11 +178,12 @@ class ReturnStmt : public Stmt
     Expr *expr;
   
   public:
-    ReturnStmt(yyltype loc, Expr *expr = NULL);
+    ReturnStmt(SourceRange loc, Expr *expr = NULL);
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_ReturnStmt; }
     const char *GetPrintNameForNode() { return "ReturnStmt"; }
     void PrintChildren(int indentLevel);
-    Type* getType(bool * typeError);
-    void Check();
+    void FlattenChildren(FlatBuilder *b);
+    Expr *GetExpr() { return expr; }
 };
 
 class SwitchLabel : public Stmt
@@ -175,28 +193,33 @@ class SwitchLabel : public Stmt
     Stmt     *stmt;
 
   public:
-    SwitchLabel() { label = NULL; stmt = NULL; }
-    SwitchLabel(Expr *label, Stmt *stmt);
-    SwitchLabel(Stmt *stmt);
+    SwitchLabel(NodeKind kind) : Stmt(kind) { label = NULL; stmt = NULL; }
+    SwitchLabel(NodeKind kind, Expr *label, Stmt *stmt);
+    SwitchLabel(NodeKind kind, Stmt *stmt);
+    static bool classof(const Node *n)
+        { return n->GetNodeKind() >= NK_Case && n->GetNodeKind() <= NK_Default; }
     void PrintChildren(int indentLevel);
+    void FlattenChildren(FlatBuilder *b);
+    Expr *GetLabel() { return label; }
+    Stmt *GetStmt() { return stmt; }
 
 };
 
 class Case : public SwitchLabel
 {
   public:
-    Case() : SwitchLabel() {}
-    Case(Expr *label, Stmt *stmt) : SwitchLabel(label, stmt) {}
+    Case() : SwitchLabel(NK_Case) {}
+    Case(Expr *label, Stmt *stmt) : SwitchLabel(NK_Case, label, stmt) {}
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_Case; }
     const char *GetPrintNameForNode() { return "Case"; }
-    void Check();
 };
 
 class Default : public SwitchLabel
 {
   public:
-    Default(Stmt *stmt) : SwitchLabel(stmt) {}
+    Default(Stmt *stmt) : SwitchLabel(NK_Default, stmt) {}
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_Default; }
     const char *GetPrintNameForNode() { return "Default"; }
-    void Check();
 };
 
 class SwitchStmt : public Stmt
@@ -207,17 +230,23 @@ class SwitchStmt : public Stmt
     Default *def;
 
   public:
-    SwitchStmt() : expr(NULL), cases(NULL), def(NULL) {}
+    SwitchStmt(NodeKind kind = NK_SwitchStmt) : Stmt(kind), expr(NULL), cases(NULL), def(NULL) {}
     SwitchStmt(Expr *expr, List<Stmt*> *cases, Default *def);
+    static bool classof(const Node *n)
+        { return n->GetNodeKind() >= NK_SwitchStmt && n->GetNodeKind() <= NK_SwitchStmtError; }
     virtual const char *GetPrintNameForNode() { return "SwitchStmt"; }
     void PrintChildren(int indentLevel);
-    void Check();
+    void FlattenChildren(FlatBuilder *b);
+    Expr *GetExpr() { return expr; }
+    List<Stmt*> *GetCases() { return cases; }
+    Default *GetDefault() { return def; }
 };
 
 class SwitchStmtError : public SwitchStmt
 {
   public:
-    SwitchStmtError(const char * msg) { yyerror(msg); }
+    SwitchStmtError(const char * msg) : SwitchStmt(NK_SwitchStmtError) { yyerror(msg); }
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_SwitchStmtError; }
     const char *GetPrintNameForNode() { return "SwitchStmtError"; }
 };
 
@@ -4,8 +4,13 @@
  */
 
 #include <string.h>
+#include <map>
+#include <mutex>
+#include <sstream>
 #include "ast_type.h"
 #include "ast_decl.h"
+#include "intern.h"
+#include "ast_flat.h"
  
 /* Class constants
  * ---------------
@@ -15,72 +20,107 @@
  * creates lots of copies.
  */
 
-Type *Type::intType    = new Type("int");
-Type *Type::floatType  = new Type("float");
-Type *Type::voidType   = new Type("void");
-Type *Type::boolType   = new Type("bool");
-Type *Type::mat2Type   = new Type("mat2");
-Type *Type::mat3Type   = new Type("mat3");
-Type *Type::mat4Type   = new Type("mat4");
-Type *Type::vec2Type   = new Type("vec2");
-Type *Type::vec3Type   = new Type("vec3");
-Type *Type::vec4Type   = new Type("vec4");
-Type *Type::ivec2Type = new Type("ivec2");
-Type *Type::ivec3Type = new Type("ivec3");
-Type *Type::ivec4Type = new Type("ivec4");
-Type *Type::bvec2Type = new Type("bvec2");
-Type *Type::bvec3Type = new Type("bvec3");
-Type *Type::bvec4Type = new Type("bvec4");
-Type *Type::uintType = new Type("uint");
-Type *Type::uvec2Type = new Type("uvec2");
-Type *Type::uvec3Type = new Type("uvec3");
-Type *Type::uvec4Type = new Type("uvec4");
-Type *Type::errorType  = new Type("error"); 
+Type *Type::builtins[NumBuiltinTypes];
+
+Type *Type::voidType   = new Type("void", TK_Void, BT_Void);
+Type *Type::boolType   = new Type("bool", TK_Bool, BT_Bool);
+Type *Type::intType    = new Type("int", TK_Int, BT_Int);
+Type *Type::uintType   = new Type("uint", TK_Uint, BT_Uint);
+Type *Type::floatType  = new Type("float", TK_Float, BT_Float);
+Type *Type::vec2Type   = new Type("vec2", TK_Vector, BT_Vec2, Type::floatType, 2);
+Type *Type::vec3Type   = new Type("vec3", TK_Vector, BT_Vec3, Type::floatType, 3);
+Type *Type::vec4Type   = new Type("vec4", TK_Vector, BT_Vec4, Type::floatType, 4);
+Type *Type::ivec2Type  = new Type("ivec2", TK_Vector, BT_IVec2, Type::intType, 2);
+Type *Type::ivec3Type  = new Type("ivec3", TK_Vector, BT_IVec3, Type::intType, 3);
+Type *Type::ivec4Type  = new Type("ivec4", TK_Vector, BT_IVec4, Type::intType, 4);
+Type *Type::bvec2Type  = new Type("bvec2", TK_Vector, BT_BVec2, Type::boolType, 2);
+Type *Type::bvec3Type  = new Type("bvec3", TK_Vector, BT_BVec3, Type::boolType, 3);
+Type *Type::bvec4Type  = new Type("bvec4", TK_Vector, BT_BVec4, Type::boolType, 4);
+Type *Type::uvec2Type  = new Type("uvec2", TK_Vector, BT_UVec2, Type::uintType, 2);
+Type *Type::uvec3Type  = new Type("uvec3", TK_Vector, BT_UVec3, Type::uintType, 3);
+Type *Type::uvec4Type  = new Type("uvec4", TK_Vector, BT_UVec4, Type::uintType, 4);
+Type *Type::mat2Type   = new Type("mat2", TK_Matrix, BT_Mat2, Type::vec2Type, 2);
+Type *Type::mat3Type   = new Type("mat3", TK_Matrix, BT_Mat3, Type::vec3Type, 3);
+Type *Type::mat4Type   = new Type("mat4", TK_Matrix, BT_Mat4, Type::vec4Type, 4);
+Type *Type::errorType  = new Type("error", TK_Error, BT_Error);
 
 TypeQualifier *TypeQualifier::inTypeQualifier  = new TypeQualifier("in");
 TypeQualifier *TypeQualifier::outTypeQualifier = new TypeQualifier("out");
 TypeQualifier *TypeQualifier::constTypeQualifier = new TypeQualifier("const");
 TypeQualifier *TypeQualifier::uniformTypeQualifier = new TypeQualifier("uniform");
 
-Type::Type(const char *n) {
+/* The registry of canonical types, keyed by shape. It is shared by every
+ * compilation in the process, so it is locked; lookups only happen when
+ * a type is written in the source, never while checking.
+ */
+struct TypeShape {
+    TypeKind kind;
+    Type *component;
+    int dim;
+    bool operator<(const TypeShape &o) const {
+        if (kind != o.kind) return kind < o.kind;
+        if (component != o.component) return component < o.component;
+        return dim < o.dim;
+    }
+};
+
+static std::mutex registryLock;
+
+static std::map<TypeShape, Type *> &Registry() {
+    static std::map<TypeShape, Type *> registry;
+    return registry;
+}
+
+Type::Type(const char *n, TypeKind k, BuiltinType b, Type *c, int d) : Node(NK_Type) {
     Assert(n);
-    typeName = strdup(n);
+    typeName = Intern(n);
+    kind = k;
+    builtin = b;
+    builtins[b] = this;
+    component = c;
+    dim = d;
+    canonical = this;
+    Register(this);
 }
 
-void Type::PrintChildren(int indentLevel) {
-    printf("%s", typeName);
+/* Returns the canonical type of t's shape: t itself, unless another
+ * thread got there first.
+ */
+Type *Type::Register(Type *t) {
+    TypeShape shape = { t->kind, t->component, t->dim };
+    std::lock_guard<std::mutex> hold(registryLock);
+    return Registry().insert(std::make_pair(shape, t)).first->second;
 }
 
-TypeQualifier::TypeQualifier(const char *n) {
-    Assert(n);
-    typeQualifierName = strdup(n);
+Type *Type::Find(TypeKind k, Type *c, int d) {
+    TypeShape shape = { k, c ? c->canonical : NULL, d };
+    std::lock_guard<std::mutex> hold(registryLock);
+    std::map<TypeShape, Type *>::iterator it = Registry().find(shape);
+    return it == Registry().end() ? NULL : it->second;
 }
 
-void TypeQualifier::PrintChildren(int indentLevel) {
-    printf("%s", typeQualifierName);
+void Type::PrintChildren(int indentLevel) {
+    fprintf(OutputFile(), "%s", typeName);
 }
 
-bool Type::IsNumeric() { 
-    return this->IsEquivalentTo(Type::intType) || this->IsEquivalentTo(Type::floatType);
+void Type::FlattenChildren(FlatBuilder *b) {
+    b->Value(canonical);
 }
 
-bool Type::IsVector() { 
-    return this->IsEquivalentTo(Type::vec2Type) || 
-           this->IsEquivalentTo(Type::vec3Type) ||  
-           this->IsEquivalentTo(Type::vec4Type);
+TypeQualifier::TypeQualifier(const char *n) : Node(NK_TypeQualifier) {
+    Assert(n);
+    typeQualifierName = Intern(n);
 }
 
-bool Type::IsMatrix() { 
-    return this->IsEquivalentTo(Type::mat2Type) || 
-           this->IsEquivalentTo(Type::mat3Type) ||  
-           this->IsEquivalentTo(Type::mat4Type);
+void TypeQualifier::PrintChildren(int indentLevel) {
+    fprintf(OutputFile(), "%s", typeQualifierName);
 }
 
-bool Type::IsError() { 
-    return this->IsEquivalentTo(Type::errorType);
+void TypeQualifier::FlattenChildren(FlatBuilder *b) {
+    b->Value(typeQualifierName);
 }
-	
-NamedType::NamedType(Identifier *i) : Type(*i->GetLocation()) {
+
+NamedType::NamedType(Identifier *i) : Type(NK_NamedType, i->GetLocation()) {
     Assert(i != NULL);
     (id=i)->SetParent(this);
 } 
@@ -89,13 +129,49 @@ void NamedType::PrintChildren(int indentLevel) {
     id->Print(indentLevel+1);
 }
 
-ArrayType::ArrayType(yyltype loc, Type *et, int ec) : Type(loc) {
+void NamedType::FlattenChildren(FlatBuilder *b) {
+    b->Child(id);
+    b->Value(canonical);
+}
+
+ArrayType::ArrayType(SourceRange loc, Type *et, int ec) : Type(NK_ArrayType, loc) {
     Assert(et != NULL);
     (elemType=et)->SetParent(this);
     elemCount=ec;
+    kind = TK_Array;
+    canonical = Get(et, ec);
+}
+
+ArrayType::ArrayType(Type *et, int ec) : Type(NK_ArrayType, SourceRange()) {
+    elemType = et;
+    elemCount = ec;
+    ostringstream name;
+    name << et << "[]";
+    typeName = Intern(name.str().c_str());
+    kind = TK_Array;
+    component = et;
+    dim = ec;
+}
+
+/* Canonical arrays outlive the arena of the compilation that first needed
+ * them, so they come from the heap rather than Node's operator new.
+ */
+ArrayType *ArrayType::Get(Type *et, int ec) {
+    et = et->GetCanonical();
+    ArrayType *t = (ArrayType *)Find(TK_Array, et, ec);
+    if (t) return t;
+    t = ::new ArrayType(et, ec);
+    ArrayType *winner = (ArrayType *)Register(t);
+    if (winner != t) ::delete t;
+    return winner;
 }
 void ArrayType::PrintChildren(int indentLevel) {
     elemType->Print(indentLevel+1);
 }
 
+void ArrayType::FlattenChildren(FlatBuilder *b) {
+    b->Child(elemType);
+    b->Value(canonical);
+}
+
 
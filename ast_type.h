@@ -7,6 +7,14 @@
  *
  * pp3: You will need to extend the Type classes to implement
  * the type system and rules for type equivalency and compatibility.
+ *
+ * Every type has one canonical Type object: the shared built-ins, and
+ * for arrays one ArrayType per element type and length, made on first
+ * use and kept for the life of the process. Types written in the source
+ * (an ArrayType with a location, say) point at their canonical type, so
+ * two types are the same exactly when their canonical pointers are
+ * equal, and what kind of type it is can be read off its TypeKind
+ * without looking at the name.
  */
  
 #ifndef _H_ast_type
@@ -18,25 +26,65 @@
 
 using namespace std;
 
+enum TypeKind {
+    TK_Void, TK_Bool, TK_Int, TK_Uint, TK_Float,
+    TK_Vector,   // component is the scalar type, dim the number of components
+    TK_Matrix,   // component is the column (vector) type, dim the number of columns
+    TK_Array,    // component is the element type, dim the number of elements
+    TK_Named,
+    TK_Error
+};
+
+// The built-in types, numbered densely so they can index tables (see
+// optypes.h). Every other type is BT_Other.
+enum BuiltinType {
+    BT_Void, BT_Bool, BT_Int, BT_Uint, BT_Float,
+    BT_Vec2, BT_Vec3, BT_Vec4,
+    BT_IVec2, BT_IVec3, BT_IVec4,
+    BT_BVec2, BT_BVec3, BT_BVec4,
+    BT_UVec2, BT_UVec3, BT_UVec4,
+    BT_Mat2, BT_Mat3, BT_Mat4,
+    BT_Error,
+    BT_Other,
+    NumBuiltinTypes
+};
+
 class TypeQualifier : public Node
 {
   protected:
-    char *typeQualifierName;
+    const char *typeQualifierName;
 
   public :
     static TypeQualifier *inTypeQualifier, *outTypeQualifier, *constTypeQualifier, *uniformTypeQualifier;
 
-    TypeQualifier(yyltype loc) : Node(loc) {}
+    TypeQualifier(SourceRange loc) : Node(NK_TypeQualifier, loc) {}
     TypeQualifier(const char *str);
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_TypeQualifier; }
+
+    // the shared built-in qualifiers have no location and no parent
+    void SetParent(Node *p) { if (location.IsValid()) Node::SetParent(p); }
 
     const char *GetPrintNameForNode() { return "TypeQualifier"; }
     void PrintChildren(int indentLevel);
+    void FlattenChildren(FlatBuilder *b);
 };
 
 class Type : public Node 
 {
   protected:
-    char *typeName;
+    const char *typeName;
+    TypeKind kind;
+    BuiltinType builtin;
+    Type *component;
+    int dim;
+    Type *canonical;
+
+    Type(const char *str, TypeKind kind, BuiltinType builtin,
+         Type *component = NULL, int dim = 1);
+    Type(NodeKind nodeKind, SourceRange loc)
+        : Node(nodeKind, loc), typeName(NULL), kind(TK_Named), builtin(BT_Other),
+          component(NULL), dim(1), canonical(this) {}
+    static Type *Register(Type *t);
 
   public :
     static Type *intType, *uintType,*floatType, *boolType, *voidType,
@@ -46,22 +94,43 @@ class Type : public Node
                 *bvec2Type, *bvec3Type, *bvec4Type, 
                 *uvec2Type, *uvec3Type,*uvec4Type, 
                 *errorType;
+    static Type *builtins[NumBuiltinTypes];
 
-    Type(yyltype loc) : Node(loc) {}
-    Type(const char *str);
+    Type(SourceRange loc) : Type(NK_Type, loc) {}
+    static bool classof(const Node *n)
+        { return n->GetNodeKind() >= NK_Type && n->GetNodeKind() <= NK_ArrayType; }
+
+          // The canonical type with the given shape, or NULL if there is
+          // none. Array types are made by ArrayType::Get() instead.
+    static Type *Find(TypeKind kind, Type *component, int dim);
+
+          // The shared Type for a built-in; BT_Other has none
+    static Type *Get(BuiltinType b) { return builtins[b]; }
+
+    // The built-in types are shared by every declaration in every parse,
+    // possibly on several threads, so only a type with a location of its
+    // own records a parent.
+    void SetParent(Node *p) { if (location.IsValid()) Node::SetParent(p); }
     
     const char *GetPrintNameForNode() { return "Type"; }
     void PrintChildren(int indentLevel);
+    void FlattenChildren(FlatBuilder *b);
 
     virtual void PrintToStream(ostream& out) { out << typeName; }
     friend ostream& operator<<(ostream& out, Type *t) { t->PrintToStream(out); return out; }
-    virtual bool IsEquivalentTo(Type *other) { return (this == other); }
-    virtual bool IsConvertibleTo(Type *other) { return (this == other || this == errorType); }
-    bool IsNumeric();
-    bool IsVector();
-    bool IsMatrix();
-    bool IsError();
-    char * GetTypeName() { return typeName; }
+    bool IsEquivalentTo(Type *other) { return canonical == other->canonical; }
+    bool IsConvertibleTo(Type *other) { return IsEquivalentTo(other) || IsError(); }
+    bool IsNumeric() { return GetKind() == TK_Int || GetKind() == TK_Float; }
+    bool IsVector() { return GetKind() == TK_Vector; }
+    bool IsMatrix() { return GetKind() == TK_Matrix; }
+    bool IsError() { return GetKind() == TK_Error; }
+    const char * GetTypeName() { return canonical->typeName; }
+
+    Type *GetCanonical() { return canonical; }
+    TypeKind GetKind() { return canonical->kind; }
+    BuiltinType GetBuiltin() { return canonical->builtin; }
+    Type *GetComponentType() { return canonical->component; }
+    int GetDimension() { return canonical->dim; }
 };
 
 
@@ -72,9 +141,11 @@ class NamedType : public Type
     
   public:
     NamedType(Identifier *i);
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_NamedType; }
     
     const char *GetPrintNameForNode() { return "NamedType"; }
     void PrintChildren(int indentLevel);
+    void FlattenChildren(FlatBuilder *b);
     void PrintToStream(ostream& out) { out << id; }
 };
 
@@ -84,11 +155,18 @@ class ArrayType : public Type
     Type *elemType;
     int   elemCount;
 
+    ArrayType(Type *elemType, int elemCount); // canonical
+
   public:
-    ArrayType(yyltype loc, Type *elemType, int elemCount);
+    ArrayType(SourceRange loc, Type *elemType, int elemCount);
+    static bool classof(const Node *n) { return n->GetNodeKind() == NK_ArrayType; }
+
+          // The canonical array of elemCount elements of elemType
+    static ArrayType *Get(Type *elemType, int elemCount);
     
     const char *GetPrintNameForNode() { return "ArrayType"; }
     void PrintChildren(int indentLevel);
+    void FlattenChildren(FlatBuilder *b);
     void PrintToStream(ostream& out) { out << elemType << "[]"; }
     Type *GetElemType() {return elemType;}
 };
@@ -0,0 +1,119 @@
+/* File: ast_visitor.h
+ * -------------------
+ * ASTVisitor is the base for code that does something different for each
+ * kind of node, such as the semantic passes. It is a template over the
+ * class deriving from it (the "curiously recurring" pattern), so that
+ * Visit() can call the derived class's VisitForStmt(), VisitCall() and so
+ * on directly, with no virtual calls: it looks at the node's NodeKind,
+ * casts the node to its class, and calls the method for that class.
+ *
+ * A derived class only writes the methods it cares about. The ones it
+ * leaves out fall back to the method for the node's base class, so
+ * VisitWhileStmt() goes to VisitLoopStmt(), then VisitConditionalStmt(),
+ * VisitStmt() and VisitNode(), which does nothing. The visitor doesn't
+ * walk the tree by itself; a Visit method visits whichever children it
+ * wants, in the order it wants them.
+ *
+ * FlatVisitor does the same over a FlatTree (see ast_flat.h), which is
+ * what the semantic passes walk: Visit() looks at the row's kind, and
+ * each method is given the row's index in place of the node.
+ */
+
+#ifndef _H_ast_visitor
+#define _H_ast_visitor
+
+#include "ast.h"
+#include "ast_decl.h"
+#include "ast_expr.h"
+#include "ast_stmt.h"
+#include "ast_type.h"
+#include "ast_flat.h"
+
+// Each node class with a NodeKind of its own, and its base class
+#define CONCRETE_NODES(X) \
+    X(Identifier, Node) X(Error, Node) X(Program, Node) \
+    X(Operator, Node) X(TypeQualifier, Node) \
+    X(Type, Node) X(NamedType, Type) X(ArrayType, Type) \
+    X(VarDecl, Decl) X(VarDeclError, VarDecl) \
+    X(FnDecl, Decl) X(FormalsError, FnDecl) \
+    X(StmtBlock, Stmt) X(DeclStmt, Stmt) \
+    X(ForStmt, LoopStmt) X(WhileStmt, LoopStmt) \
+    X(IfStmt, ConditionalStmt) X(IfStmtExprError, IfStmt) \
+    X(BreakStmt, Stmt) X(ContinueStmt, Stmt) X(ReturnStmt, Stmt) \
+    X(Case, SwitchLabel) X(Default, SwitchLabel) \
+    X(SwitchStmt, Stmt) X(SwitchStmtError, SwitchStmt) \
+    X(ExprError, Expr) X(EmptyExpr, Expr) \
+    X(IntConstant, Expr) X(FloatConstant, Expr) X(BoolConstant, Expr) \
+    X(VarExpr, Expr) \
+    X(ArithmeticExpr, CompoundExpr) X(RelationalExpr, CompoundExpr) \
+    X(EqualityExpr, CompoundExpr) X(LogicalExpr, CompoundExpr) \
+    X(AssignExpr, CompoundExpr) X(PostfixExpr, CompoundExpr) \
+    X(ConditionalExpr, Expr) \
+    X(ArrayAccess, LValue) X(FieldAccess, LValue) \
+    X(Call, Expr) X(ActualsError, Call)
+
+// The classes that are only ever bases, and their own base classes
+#define ABSTRACT_NODES(X) \
+    X(Decl, Node) X(Stmt, Node) \
+    X(ConditionalStmt, Stmt) X(LoopStmt, ConditionalStmt) \
+    X(SwitchLabel, Stmt) \
+    X(Expr, Stmt) X(CompoundExpr, Expr) X(LValue, Expr)
+
+template<class Derived, class RetTy = void>
+class ASTVisitor
+{
+  public:
+    RetTy Visit(Node *n) {
+        switch (n->GetNodeKind()) {
+#define DISPATCH(Class, Base) \
+          case NK_##Class: \
+            return static_cast<Derived *>(this)->Visit##Class(static_cast<Class *>(n));
+        CONCRETE_NODES(DISPATCH)
+#undef DISPATCH
+        }
+        Assert(0);
+        return RetTy();
+    }
+
+    RetTy VisitNode(Node *n) { return RetTy(); }
+
+#define FALLBACK(Class, Base) \
+    RetTy Visit##Class(Class *n) { return static_cast<Derived *>(this)->Visit##Base(n); }
+    ABSTRACT_NODES(FALLBACK)
+    CONCRETE_NODES(FALLBACK)
+#undef FALLBACK
+};
+
+template<class Derived, class RetTy = void>
+class FlatVisitor
+{
+  protected:
+    FlatTree *tree;     // the tree being visited, set by the derived class
+
+  public:
+    typedef FlatTree::Index Row;
+
+    FlatVisitor() : tree(NULL) {}
+
+    RetTy Visit(Row n) {
+        switch (tree->Kind(n)) {
+#define DISPATCH(Class, Base) \
+          case NK_##Class: \
+            return static_cast<Derived *>(this)->Visit##Class(n);
+        CONCRETE_NODES(DISPATCH)
+#undef DISPATCH
+        }
+        Assert(0);
+        return RetTy();
+    }
+
+    RetTy VisitNode(Row n) { return RetTy(); }
+
+#define FALLBACK(Class, Base) \
+    RetTy Visit##Class(Row n) { return static_cast<Derived *>(this)->Visit##Base(n); }
+    ABSTRACT_NODES(FALLBACK)
+    CONCRETE_NODES(FALLBACK)
+#undef FALLBACK
+};
+
+#endif
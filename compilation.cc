@@ -0,0 +1,161 @@
+/* File: compilation.cc
+ * --------------------
+ * Implementation of CompilationContext: compiling one shader from start
+ * to finish.
+ */
+
+#include "compilation.h"
+#include "errors.h"
+#include "parser.h"
+#include "semantic.h"
+#include "allocstats.h"
+
+static thread_local CompilationContext *currentContext = NULL;
+
+
+/* Function: PrintAllocStats()
+ * ----------------------------
+ * Prints the heap allocations made by each phase of the compilation:
+ * the parse (with --stream, reading the input as it arrives too, but not
+ * the passes run along the way), then each pass.
+ */
+static void PrintAllocStats(AllocStats parse, PassManager *passes)
+{
+    FILE *out = ErrorFile();
+    fprintf(out, "%-12s %12s %12s\n", "phase", "allocations", "bytes");
+    fprintf(out, "%-12s %12llu %12llu\n", "parse",
+            (unsigned long long)parse.count, (unsigned long long)parse.bytes);
+    for (int i = 0; i < passes->NumPasses(); i++) {
+        AllocStats s = passes->GetAllocStats(i);
+        fprintf(out, "%-12s %12llu %12llu\n", passes->GetPass(i)->GetName(),
+                (unsigned long long)s.count, (unsigned long long)s.bytes);
+    }
+}
+
+
+CompilationContext::CompilationContext(ThreadPool *pool)
+  : debugKeys(CommandLineDebugKeys()), numErrors(0), scanner(NULL),
+    memoryInput(NULL), diagnostics(NULL)
+{
+    AddSemanticPasses(&passes, pool);
+}
+
+CompilationContext::~CompilationContext()
+{
+    delete memoryInput;
+}
+
+CompilationContext *CompilationContext::Current()
+{
+    return currentContext;
+}
+
+bool CompilationContext::Collect(const yyltype *loc, const std::string &message)
+{
+    if (!diagnostics) return false;
+    GlcDiagnostic d = { 0, 0, 0, 0, message };
+    if (loc) {
+        d.line = loc->first_line;
+        d.column = loc->first_column;
+        d.lastLine = loc->last_line;
+        d.lastColumn = loc->last_column;
+    }
+    std::lock_guard<std::mutex> hold(diagnosticsLock);
+    diagnostics->push_back(d);
+    return true;
+}
+
+
+/* Function: Compile()
+ * -------------------
+ * InitScanner() is used to set up the scanner, and Run() does the rest.
+ * With --stream the input is instead read as it arrives.
+ */
+int CompilationContext::Compile(const char *path)
+{
+    CompilationScope useContext(this);
+    ScanContext input;
+    AllocStats start = GetAllocStats();
+    if (GetOption("stream"))
+        InitStreamScanner(&input, path);
+    else
+        InitScanner(&input, path);
+    return Run(&input, start);
+}
+
+int CompilationContext::Compile(const char *text, size_t len, bool useFastScanner)
+{
+    CompilationScope useContext(this);
+    if (!memoryInput)
+        memoryInput = new ScanContext;
+    AllocStats start = GetAllocStats();
+    InitScanner(memoryInput, text, len, useFastScanner);
+    return Run(memoryInput, start);
+}
+
+
+/* Function: Run()
+ * ---------------
+ * The call to yyparse() will attempt to parse a complete program from
+ * the input, and if that succeeds without errors the program is then run
+ * through the semantic passes, which work on the flat tree the parser
+ * built alongside it (see ast_flat.h). Input being streamed is instead parsed as
+ * it is read, and each declaration is checked as soon as it has been
+ * parsed. Everything built along the way comes from the context's arena,
+ * which is emptied for the next compilation when this one starts.
+ */
+int CompilationContext::Run(ScanContext *input, AllocStats start)
+{
+    arena.Rewind();
+    ArenaScope useArena(&arena);
+    ParseResult result;
+    scanner = input;
+    numErrors = 0;
+
+    if (input->streamFd >= 0) {
+        ParseStream(input, &result, &passes);
+        AllocStats parse = GetAllocStats() - start - passes.GetAllocStats();
+        if (result.program && IsDebugOn("dumpAST"))
+            result.program->Print(0);
+        if (result.program && IsDebugOn("dumpFlat"))
+            result.tree.Print();
+        if (IsDebugOn("timePasses"))
+            passes.PrintTimings(ErrorFile());
+        if (IsDebugOn("allocstats"))
+            PrintAllocStats(parse, &passes);
+        scanner = NULL;
+        return (NumErrors() == 0? 0 : -1);
+    }
+
+    yyparse(input, &result);
+    AllocStats parse = GetAllocStats() - start;
+    passes.Begin();
+    // if no errors, advance to next phase
+    if (result.program && NumErrors() == 0) {
+        if (IsDebugOn("dumpAST"))
+            result.program->Print(0);
+        if (IsDebugOn("dumpFlat"))
+            result.tree.Print();
+        passes.Run(&result.tree, result.program->GetRow());
+        if (IsDebugOn("timePasses"))
+            passes.PrintTimings(ErrorFile());
+    }
+    if (IsDebugOn("allocstats"))
+        PrintAllocStats(parse, &passes);
+    scanner = NULL;
+    return (NumErrors() == 0? 0 : -1);
+}
+
+
+CompilationScope::CompilationScope(CompilationContext *context)
+{
+    saved = currentContext;
+    savedKeys = UseDebugKeys(&context->debugKeys);
+    currentContext = context;
+}
+
+CompilationScope::~CompilationScope()
+{
+    currentContext = saved;
+    UseDebugKeys(savedKeys);
+}
@@ -0,0 +1,109 @@
+/* File: compilation.h
+ * -------------------
+ * This file defines CompilationContext, which holds everything about one
+ * compilation: the arena its tree is built in, the input being scanned,
+ * the passes (and with them the symbol table), the count of errors
+ * reported and the debug keys that are on. No state about compiling a
+ * shader is kept anywhere else, so any number of compilations can run
+ * at once on different threads. A context can also be used for one
+ * input after another, and keeps its storage from one to the next: the
+ * arena's block, the symbol table's buckets and, for text compiled from
+ * memory, the scanner and its buffer.
+ *
+ *    CompilationContext context(NULL);
+ *    context.SetDebugForKey("dumpAST", true);
+ *    int status = context.Compile("shader.glsl");
+ *
+ * Code deep inside the compiler, such as ReportError or IsDebugOn(),
+ * finds the context through the thread it runs on. A CompilationScope
+ * makes a context current on a thread for as long as it lasts, the way
+ * an ArenaScope does an arena; Compile() puts one up itself, and a thread
+ * that helps with a compilation (see CheckPass) puts up its own.
+ */
+
+#ifndef _H_compilation
+#define _H_compilation
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "arena.h"
+#include "location.h"
+#include "passes.h"
+#include "utility.h"
+#include "glc.h"
+
+class ScanContext;
+class ThreadPool;
+
+class CompilationContext
+{
+    Arena arena;
+    PassManager passes;
+    DebugKeySet debugKeys;
+    std::atomic<int> numErrors;
+    ScanContext *scanner;         // the input being compiled, or NULL
+    ScanContext *memoryInput;     // kept for Compile() from memory
+    std::vector<GlcDiagnostic> *diagnostics;
+    std::mutex diagnosticsLock;
+
+    int Run(ScanContext *input, AllocStats start);
+
+  public:
+          // Given a pool, the declarations of each program are checked
+          // on its threads. The debug keys start out as the command line's.
+    explicit CompilationContext(ThreadPool *pool);
+    ~CompilationContext();
+
+          // Compiles one shader, read from the named file or from stdin if
+          // path is NULL, and returns 0 if it had no errors or -1 if it did
+    int Compile(const char *path);
+
+          // Compiles len bytes of text, which need not be terminated, with
+          // the hand-written scanner or flex
+    int Compile(const char *text, size_t len, bool useFastScanner);
+
+    PassManager *GetPasses() { return &passes; }
+
+    void SetDebugKeys(const DebugKeySet &keys) { debugKeys = keys; }
+    void SetDebugForKey(const char *key, bool value) { debugKeys.Set(key, value); }
+    bool IsDebugOn(const char *key) const { return debugKeys.IsOn(key); }
+
+    int NumErrors() const { return numErrors; }
+    void CountError() { numErrors++; }
+
+          // Has errors collected into list, in the order they are
+          // reported, instead of written to ErrorFile(); NULL to have
+          // them written out again
+    void CollectDiagnostics(std::vector<GlcDiagnostic> *list) { diagnostics = list; }
+
+          // Adds an error to the list being collected, if there is one;
+          // false if it should be written out instead
+    bool Collect(const yyltype *loc, const std::string &message);
+
+          // The input Compile() is working on, where error messages
+          // quote source lines from; NULL between compilations
+    ScanContext *GetScanner() const { return scanner; }
+
+          // The context current on the calling thread, or NULL
+    static CompilationContext *Current();
+
+  private:
+    friend class CompilationScope;
+
+    CompilationContext(const CompilationContext &);
+    CompilationContext &operator=(const CompilationContext &);
+};
+
+class CompilationScope
+{
+    CompilationContext *saved;
+    const DebugKeySet *savedKeys;
+
+  public:
+    explicit CompilationScope(CompilationContext *context);
+    ~CompilationScope();
+};
+
+#endif
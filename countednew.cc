@@ -0,0 +1,44 @@
+/* File: countednew.cc
+ * --------------------
+ * The replacement global operator new and delete that count glc's heap
+ * allocations (see allocstats.h). These just count and pass the request
+ * on to malloc/free. They are linked into glc only: a program using the
+ * library keeps its own operator new, and -d allocstats there counts
+ * just the arena's blocks.
+ */
+
+#include <stdlib.h>
+#include <new>
+#include "allocstats.h"
+
+static void *CountedMalloc(size_t size) {
+    CountAllocation(size);
+    return malloc(size ? size : 1);
+}
+
+void *operator new(size_t size) {
+    void *p = CountedMalloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size) {
+    void *p = CountedMalloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return CountedMalloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return CountedMalloc(size);
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { free(p); }
@@ -12,32 +12,49 @@
 using namespace std;
 
 #include "scanner.h" // for GetLineNumbered
+#include "parser.h"  // for yyerror parameters
 #include "ast_type.h"
-#include "ast_expr.h"
-#include "ast_stmt.h"
-#include "ast_decl.h"
+#include "compilation.h"
 
-int ReportError::numErrors = 0;
+int ReportError::NumErrors() {
+    CompilationContext *context = CompilationContext::Current();
+    return (context ? context->NumErrors() : 0);
+}
 
-void ReportError::UnderlineErrorInLine(const char *line, yyltype *pos) {
+void ReportError::UnderlineErrorInLine(const char *line, int len, yyltype *pos) {
     if (!line) return;
-    cerr << line << endl;
+    FILE *err = ErrorFile();
+    fprintf(err, "%.*s\n", len, line);
     for (int i = 1; i <= pos->last_column; i++)
-        cerr << (i >= pos->first_column ? '^' : ' ');
-    cerr << endl;
+        fputc(i >= pos->first_column ? '^' : ' ', err);
+    fputc('\n', err);
 }
 
  
  
 void ReportError::OutputError(yyltype *loc, string msg) {
-    numErrors++;
-    fflush(stdout); // make sure any buffered text has been output
+    CompilationContext *context = CompilationContext::Current();
+    if (context) {
+        context->CountError();
+        if (context->Collect(loc, msg)) return;
+    }
+    fflush(OutputFile()); // make sure any buffered text has been output
+    FILE *err = ErrorFile();
     if (loc) {
-        cerr << endl << "*** Error line " << loc->first_line << "." << endl;
-        UnderlineErrorInLine(GetLineNumbered(loc->first_line), loc);
+        int len = 0;
+        fprintf(err, "\n*** Error line %d.\n", loc->first_line);
+        const char *line = GetLineNumbered(loc->first_line, &len);
+        UnderlineErrorInLine(line, len, loc);
     } else
-        cerr << endl << "*** Error." << endl;
-    cerr << "*** " << msg << endl << endl;
+        fprintf(err, "\n*** Error.\n");
+    fprintf(err, "*** %s\n\n", msg.c_str());
+    fflush(err);
+}
+
+
+void ReportError::OutputError(SourceRange range, string msg) {
+    yyltype loc = ExpandRange(range);
+    OutputError(range.IsValid() ? &loc : NULL, msg);
 }
 
 
@@ -74,122 +91,122 @@ void ReportError::UnrecogChar(yyltype *loc, char ch) {
     OutputError(loc, s.str());
 }
 
-void ReportError::DeclConflict(Decl *decl, Decl *prevDecl) {
+void ReportError::DeclConflict(const FlatTree *t, Row decl, Row prevDecl) {
     ostringstream s;
-    s << "Declaration of '" << decl << "' here conflicts with declaration on line " 
-      << prevDecl->GetLocation()->first_line;
-    OutputError(decl->GetLocation(), s.str());
+    s << "Declaration of '" << t->value[t->DeclId(decl)].name << "' here conflicts with declaration on line " 
+      << ExpandRange(t->range[prevDecl]).first_line;
+    OutputError(t->range[decl], s.str());
 }
 
-void ReportError::InvalidInitialization(Identifier *id, Type *lType, Type *rType) {
+void ReportError::InvalidInitialization(const FlatTree *t, Row id, Type *lType, Type *rType) {
     ostringstream s;
-    s << "Wrong initialization of identifier '" << id << "': idType '" 
+    s << "Wrong initialization of identifier '" << t->value[id].name << "': idType '" 
       << lType << "' exprType '" << rType << "'" ;
-    OutputError(id->GetLocation(), s.str());
+    OutputError(t->range[id], s.str());
 }
 
-void ReportError::IdentifierNotDeclared(Identifier *ident, reasonT whyNeeded) {
+void ReportError::IdentifierNotDeclared(const FlatTree *t, Row ident, reasonT whyNeeded) {
     ostringstream s;
     static const char *names[] =  {"type", "variable", "function"};
     Assert(whyNeeded >= 0 && whyNeeded <= sizeof(names)/sizeof(names[0]));
-    s << "No declaration found for "<< names[whyNeeded] << " '" << ident << "'";
-    OutputError(ident->GetLocation(), s.str());
+    s << "No declaration found for "<< names[whyNeeded] << " '" << t->value[ident].name << "'";
+    OutputError(t->range[ident], s.str());
 }
 
-void ReportError::ExtraFormals(Identifier *id, int expCount, int actualCount) {
+void ReportError::ExtraFormals(const FlatTree *t, Row id, int expCount, int actualCount) {
     ostringstream s;
-    s << "Extra arguments given to function '" << id << "': expected " 
+    s << "Extra arguments given to function '" << t->value[id].name << "': expected " 
       << expCount << ", given " << actualCount ;
-    OutputError(id->GetLocation(), s.str());
+    OutputError(t->range[id], s.str());
 }
 
-void ReportError::LessFormals(Identifier *id, int expCount, int actualCount) {
+void ReportError::LessFormals(const FlatTree *t, Row id, int expCount, int actualCount) {
     ostringstream s;
-    s << "Less arguments given to function '" << id << "': expected " 
+    s << "Less arguments given to function '" << t->value[id].name << "': expected " 
       << expCount << ", given " << actualCount ;
-    OutputError(id->GetLocation(), s.str());
+    OutputError(t->range[id], s.str());
 }
 
-void ReportError::FormalsTypeMismatch(Identifier *id, int pos, Type *expType, Type *actualType)
+void ReportError::FormalsTypeMismatch(const FlatTree *t, Row id, int pos, Type *expType, Type *actualType)
 { 
     ostringstream s;
-    s << "Formal type mismatch in function '" << id << "' at pos " << pos 
+    s << "Formal type mismatch in function '" << t->value[id].name << "' at pos " << pos 
       << ": expected '" << expType << "', given '" << actualType <<"'";
-    OutputError(id->GetLocation(), s.str());
+    OutputError(t->range[id], s.str());
 }
 
-void ReportError::NotAFunction(Identifier *id) {
+void ReportError::NotAFunction(const FlatTree *t, Row id) {
     ostringstream s;
-    s << "'" << id << "' is not a function.";
-    OutputError(id->GetLocation(), s.str());
+    s << "'" << t->value[id].name << "' is not a function.";
+    OutputError(t->range[id], s.str());
 }
 
-void ReportError::NotAnArray(Identifier *id) {
+void ReportError::NotAnArray(const FlatTree *t, Row id) {
     ostringstream s;
-    s << "'" << id << "' is not an array.";
-    OutputError(id->GetLocation(), s.str());
+    s << "'" << t->value[id].name << "' is not an array.";
+    OutputError(t->range[id], s.str());
 }
 
-void ReportError::IncompatibleOperands(Operator *op, Type *lhs, Type *rhs) {
+void ReportError::IncompatibleOperands(const FlatTree *t, Row op, Type *lhs, Type *rhs) {
     ostringstream s;
-    s << "Incompatible operands: " << lhs << " " << op << " " << rhs;
-    OutputError(op->GetLocation(), s.str());
+    s << "Incompatible operands: " << lhs << " " << OpSpelling(t->value[op].op) << " " << rhs;
+    OutputError(t->range[op], s.str());
 }
      
-void ReportError::IncompatibleOperand(Operator *op, Type *rhs) {
+void ReportError::IncompatibleOperand(const FlatTree *t, Row op, Type *rhs) {
     ostringstream s;
-    s << "Incompatible operand: " << op << " " << rhs;
-    OutputError(op->GetLocation(), s.str());
+    s << "Incompatible operand: " << OpSpelling(t->value[op].op) << " " << rhs;
+    OutputError(t->range[op], s.str());
 }
 
-void ReportError::ReturnMismatch(ReturnStmt *rStmt, Type *given, Type *expected) {
+void ReportError::ReturnMismatch(const FlatTree *t, Row rStmt, Type *given, Type *expected) {
     ostringstream s;
     s << "Incompatible return: " << given << " given, " << expected << " expected";
-    OutputError(rStmt->GetLocation(), s.str());
+    OutputError(t->range[rStmt], s.str());
 }
 
-void ReportError::ReturnMissing(FnDecl *fnDecl) {
+void ReportError::ReturnMissing(const FlatTree *t, Row fnDecl) {
     ostringstream s;
-    s << "Declaration of '" << fnDecl << "' on line " 
-      << fnDecl->GetLocation()->first_line
+    s << "Declaration of '" << t->value[t->DeclId(fnDecl)].name << "' on line " 
+      << ExpandRange(t->range[fnDecl]).first_line
       << " doesn't have a return";
-    OutputError(fnDecl->GetLocation(), s.str());
+    OutputError(t->range[fnDecl], s.str());
 }
 
-void ReportError::InaccessibleSwizzle(Identifier *field, Expr *base) {
+void ReportError::InaccessibleSwizzle(const FlatTree *t, Row field, Row base) {
     ostringstream s;
-    s << base << " non-vector type can't have swizzle '" << field <<"'";
-    OutputError(field->GetLocation(), s.str());
+    s << t->name[base] << " non-vector type can't have swizzle '" << t->value[field].name <<"'";
+    OutputError(t->range[field], s.str());
 }
      
-void ReportError::InvalidSwizzle(Identifier *field, Expr *base) {
+void ReportError::InvalidSwizzle(const FlatTree *t, Row field, Row base) {
     ostringstream s;
-    s << base << " swizzle '" << field <<"' is not proper subset of [xyzw]";
-    OutputError(field->GetLocation(), s.str());
+    s << t->name[base] << " swizzle '" << t->value[field].name <<"' is not proper subset of [xyzw]";
+    OutputError(t->range[field], s.str());
 }
      
-void ReportError::SwizzleOutOfBound(Identifier *field, Expr *base) {
+void ReportError::SwizzleOutOfBound(const FlatTree *t, Row field, Row base) {
     ostringstream s;
-    s << base << " swizzle '" << field <<"' exceeds its vector component";
-    OutputError(field->GetLocation(), s.str());
+    s << t->name[base] << " swizzle '" << t->value[field].name <<"' exceeds its vector component";
+    OutputError(t->range[field], s.str());
 }
 
-void ReportError::OversizedVector(Identifier *field, Expr *base) {
+void ReportError::OversizedVector(const FlatTree *t, Row field, Row base) {
     ostringstream s;
-    s << base << " swizzle '" << field <<"' generates a vector longer than vec4";
-    OutputError(field->GetLocation(), s.str());
+    s << t->name[base] << " swizzle '" << t->value[field].name <<"' generates a vector longer than vec4";
+    OutputError(t->range[field], s.str());
 }
 
-void ReportError::TestNotBoolean(Expr *expr) {
-    OutputError(expr->GetLocation(), "Test expression must have boolean type");
+void ReportError::TestNotBoolean(const FlatTree *t, Row expr) {
+    OutputError(t->range[expr], "Test expression must have boolean type");
 }
 
-void ReportError::BreakOutsideLoop(BreakStmt *bStmt) {
-    OutputError(bStmt->GetLocation(), "break is only allowed inside a loop");
+void ReportError::BreakOutsideLoop(const FlatTree *t, Row bStmt) {
+    OutputError(t->range[bStmt], "break is only allowed inside a loop");
 }
   
-void ReportError::ContinueOutsideLoop(ContinueStmt *cStmt) {
-    OutputError(cStmt->GetLocation(), "continue is only allowed inside a loop");
+void ReportError::ContinueOutsideLoop(const FlatTree *t, Row cStmt) {
+    OutputError(t->range[cStmt], "continue is only allowed inside a loop");
 }
 
 /**
@@ -197,12 +214,14 @@ void ReportError::ContinueOutsideLoop(ContinueStmt *cStmt) {
  * -------------------
  * Standard error-reporting function expected by yacc. Our version merely
  * just calls into the error reporter above, passing the location of
- * the last token read. If you want to suppress the ordinary "parse error"
+ * the last token read. The pure parser also passes its parse parameters,
+ * which are not needed here. If you want to suppress the ordinary "parse error"
  * message from yacc, you can implement yyerror to do nothing and
  * then call ReportError::Formatted yourself with a more descriptive 
  * message.
  */
 
-void yyerror(const char *msg) {
-    ReportError::Formatted(&yylloc, "%s", msg);
+void yyerror(yyltype *loc, ScanContext *scanner, ParseResult *result,
+             const char *msg) {
+    ReportError::Formatted(loc, "%s", msg);
 }
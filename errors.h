@@ -16,6 +16,7 @@
 #include <string>
 #include "location.h"
 #include "ast_decl.h"
+#include "ast_flat.h"
 
 using namespace std;
 
@@ -30,25 +31,19 @@ using namespace std;
  * the class name, e.g.
  *
  *    if (missingEnd) { 
- *       ReportError::UntermString(&yylloc, str);
+ *       ReportError::UntermString(yylloc, str);
  *    }
  *
  * For some methods, the first argument is the pointer to the location
  * structure that identifies where the problem is (usually this is the
  * location of the offending token). You can pass NULL for the argument
- * if there is no appropriate position to point out. For other methods,
- * location is accessed by messaging the node in error which is passed
- * as an argument. You cannot pass NULL for these arguments.
+ * if there is no appropriate position to point out. The methods for the
+ * semantic errors are given the flat tree being checked (see ast_flat.h)
+ * and the row of each node in question, which must be a row of the
+ * kind the parameter's name says, and the location comes from there.
  */
 
 class Type;
-class Identifier;
-class Expr;
-class BreakStmt;
-class ContinueStmt;
-class ReturnStmt;
-class Decl;
-class Operator;
 
 typedef enum {
       LookingForType,
@@ -58,6 +53,7 @@ typedef enum {
 
 class ReportError {
  public:
+  typedef FlatTree::Index Row;
 
   // Errors used by scanner
   static void UntermComment(); 
@@ -66,49 +62,50 @@ class ReportError {
   static void UnrecogChar(yyltype *loc, char ch);
 
   // Errors used by semantic analyzer for declarations
-  static void DeclConflict(Decl *newDecl, Decl *prevDecl);
-  static void InvalidInitialization(Identifier *id, Type *lType, Type *rType);
+  static void DeclConflict(const FlatTree *t, Row newDecl, Row prevDecl);
+  static void InvalidInitialization(const FlatTree *t, Row id, Type *lType, Type *rType);
   
   
   // Errors used by semantic analyzer for identifiers
-  static void IdentifierNotDeclared(Identifier *ident, reasonT whyNeeded);
+  static void IdentifierNotDeclared(const FlatTree *t, Row ident, reasonT whyNeeded);
 
   // Errors used by semantic analyzer for arrays
-  static void NotAnArray(Identifier *id);
+  static void NotAnArray(const FlatTree *t, Row id);
               
   // Errors used by semantic analyzer for expressions
-  static void IncompatibleOperand(Operator *op, Type *rhs); // unary
-  static void IncompatibleOperands(Operator *op, Type *lhs, Type *rhs); // binary
+  static void IncompatibleOperand(const FlatTree *t, Row op, Type *rhs); // unary
+  static void IncompatibleOperands(const FlatTree *t, Row op, Type *lhs, Type *rhs); // binary
 
   // Errors used by semantic analyzer for function calls
-  static void ExtraFormals(Identifier *id, int expCount, int actualCount); 
-  static void LessFormals(Identifier *id, int expCount, int actualCount); 
-  static void FormalsTypeMismatch(Identifier *id, int pos, Type *expType, Type *actualType); 
-  static void NotAFunction(Identifier *id); 
+  static void ExtraFormals(const FlatTree *t, Row id, int expCount, int actualCount); 
+  static void LessFormals(const FlatTree *t, Row id, int expCount, int actualCount); 
+  static void FormalsTypeMismatch(const FlatTree *t, Row id, int pos, Type *expType, Type *actualType); 
+  static void NotAFunction(const FlatTree *t, Row id); 
   
   // Errors used by semantic analyzer for vector access
-  static void InaccessibleSwizzle(Identifier *swizzle, Expr *base);
-  static void InvalidSwizzle(Identifier *swizzle, Expr *base);
-  static void SwizzleOutOfBound(Identifier *swizzle, Expr *base);
-  static void OversizedVector(Identifier *swizzle, Expr *base);
+  static void InaccessibleSwizzle(const FlatTree *t, Row swizzle, Row base);
+  static void InvalidSwizzle(const FlatTree *t, Row swizzle, Row base);
+  static void SwizzleOutOfBound(const FlatTree *t, Row swizzle, Row base);
+  static void OversizedVector(const FlatTree *t, Row swizzle, Row base);
   
   // Errors used by semantic analyzer for control structures
-  static void TestNotBoolean(Expr *testExpr);
-  static void ReturnMismatch(ReturnStmt *rStmt, Type *given, Type *expected);
-  static void ReturnMissing(FnDecl *fnDecl);
-  static void BreakOutsideLoop(BreakStmt *bStmt); 
-  static void ContinueOutsideLoop(ContinueStmt *cStmt); 
+  static void TestNotBoolean(const FlatTree *t, Row testExpr);
+  static void ReturnMismatch(const FlatTree *t, Row rStmt, Type *given, Type *expected);
+  static void ReturnMissing(const FlatTree *t, Row fnDecl);
+  static void BreakOutsideLoop(const FlatTree *t, Row bStmt); 
+  static void ContinueOutsideLoop(const FlatTree *t, Row cStmt); 
 
   // Generic method to report a printf-style error message
   static void Formatted(yyltype *loc, const char *format, ...);
 
 
-  // Returns number of error messages printed
-  static int NumErrors() { return numErrors; }
+  // Returns number of error messages printed for the compilation under
+  // way on this thread (see compilation.h)
+  static int NumErrors();
   
  private:
-  static void UnderlineErrorInLine(const char *line, yyltype *pos);
+  static void UnderlineErrorInLine(const char *line, int len, yyltype *pos);
   static void OutputError(yyltype *loc, string msg);
-  static int numErrors;
+  static void OutputError(SourceRange range, string msg);
 };
 #endif
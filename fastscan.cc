@@ -0,0 +1,340 @@
+/* File: fastscan.cc
+ * -----------------
+ * Implementation of the hand-written scanner. Every rule here has a
+ * counterpart in scanner.l; keep the two in step when either changes.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <string>
+#include "fastscan.h"
+#include "scanner.h"
+#include "errors.h"
+#include "intern.h"
+#include "parser.h" // for token codes, YYSTYPE
+
+#define TAB_SIZE 8
+
+/* Character classes and DFA
+ * -------------------------
+ * The DFA covers the IDENTIFIER, INTEGER, HEX_INTEGER and FLOAT patterns
+ * of scanner.l. Hex digits are split out of the letters because they
+ * continue a hex constant, and f/F further because it also ends a float.
+ * A lexeme starts in S_Start on a letter or digit and runs until the DFA
+ * dies; the longest prefix that ended in an accepting state wins.
+ */
+enum CharClass { C_Other, C_Zero, C_Digit, C_X, C_Hex, C_F, C_Alpha,
+                 C_Under, C_Dot, NumCharClasses };
+
+enum DfaState { S_Dead, S_Start, S_Ident, S_Zero, S_Int, S_ZeroX, S_Hex,
+                S_Frac, S_FloatSuffix, NumDfaStates };
+
+static const unsigned char delta[NumDfaStates][NumCharClasses] = {
+ /*                Other   Zero     Digit    X        Hex      F        Alpha    Under    Dot    */
+ /* Dead    */   { S_Dead, S_Dead,  S_Dead,  S_Dead,  S_Dead,  S_Dead,  S_Dead,  S_Dead,  S_Dead },
+ /* Start   */   { S_Dead, S_Zero,  S_Int,   S_Ident, S_Ident, S_Ident, S_Ident, S_Dead,  S_Dead },
+ /* Ident   */   { S_Dead, S_Ident, S_Ident, S_Ident, S_Ident, S_Ident, S_Ident, S_Ident, S_Dead },
+ /* Zero    */   { S_Dead, S_Int,   S_Int,   S_ZeroX, S_Dead,  S_Dead,  S_Dead,  S_Dead,  S_Frac },
+ /* Int     */   { S_Dead, S_Int,   S_Int,   S_Dead,  S_Dead,  S_Dead,  S_Dead,  S_Dead,  S_Frac },
+ /* ZeroX   */   { S_Dead, S_Hex,   S_Hex,   S_Dead,  S_Hex,   S_Hex,   S_Dead,  S_Dead,  S_Dead },
+ /* Hex     */   { S_Dead, S_Hex,   S_Hex,   S_Dead,  S_Hex,   S_Hex,   S_Dead,  S_Dead,  S_Dead },
+ /* Frac    */   { S_Dead, S_Frac,  S_Frac,  S_Dead,  S_Dead,  S_FloatSuffix, S_Dead, S_Dead, S_Dead },
+ /* FloatSuffix*/{ S_Dead, S_Dead,  S_Dead,  S_Dead,  S_Dead,  S_Dead,  S_Dead,  S_Dead,  S_Dead },
+};
+
+static const bool accepting[NumDfaStates] = {
+    false, false, true, true, true, false, true, true, true
+};
+
+static unsigned char charClass[256];
+
+static void InitCharClasses() {
+    for (int c = 'a'; c <= 'z'; c++) charClass[c] = charClass[c-'a'+'A'] = C_Alpha;
+    for (int c = 'a'; c <= 'e'; c++) charClass[c] = charClass[c-'a'+'A'] = C_Hex;
+    charClass['f'] = charClass['F'] = C_F;
+    charClass['x'] = charClass['X'] = C_X;
+    for (int c = '1'; c <= '9'; c++) charClass[c] = C_Digit;
+    charClass['0'] = C_Zero;
+    charClass['_'] = C_Under;
+    charClass['.'] = C_Dot;
+}
+
+
+/* Keywords
+ * --------
+ * Reserved words (and the boolean literals, which flex also matches
+ * ahead of IDENTIFIER) live in a 128-slot table indexed by a hash of the
+ * first, second and last characters and the length. The multipliers were
+ * chosen so that no two words collide; InitKeywords() asserts as much.
+ */
+struct Keyword {
+    const char *word;
+    int token;
+};
+
+static const Keyword keywords[] = {
+    {"void", T_Void}, {"int", T_Int}, {"float", T_Float}, {"bool", T_Bool},
+    {"while", T_While}, {"for", T_For}, {"if", T_If}, {"else", T_Else},
+    {"return", T_Return}, {"break", T_Break}, {"switch", T_Switch},
+    {"case", T_Case}, {"default", T_Default}, {"const", T_Const},
+    {"uniform", T_Uniform}, {"continue", T_Continue}, {"do", T_Do},
+    {"in", T_In}, {"out", T_Out}, {"mat2", T_Mat2}, {"mat3", T_Mat3},
+    {"mat4", T_Mat4}, {"vec2", T_Vec2}, {"vec3", T_Vec3}, {"vec4", T_Vec4},
+    {"ivec2", T_Ivec2}, {"ivec3", T_Ivec3}, {"ivec4", T_Ivec4},
+    {"bvec2", T_Bvec2}, {"bvec3", T_Bvec3}, {"bvec4", T_Bvec4},
+    {"uint", T_Uint}, {"uvec2", T_Uvec2}, {"uvec3", T_Uvec3},
+    {"uvec4", T_Uvec4}, {"true", T_BoolConstant}, {"false", T_BoolConstant},
+};
+
+static const int KeywordSlots = 128;
+static const int MinKeywordLen = 2, MaxKeywordLen = 8;
+static const Keyword *keywordTable[KeywordSlots];
+
+static inline int KeywordHash(const char *s, int len) {
+    const unsigned char *u = (const unsigned char *)s;
+    return (u[0] + 5*u[1] + 5*u[len-1] + len) & (KeywordSlots - 1);
+}
+
+static void InitKeywords() {
+    for (size_t i = 0; i < sizeof(keywords)/sizeof(keywords[0]); i++) {
+        int h = KeywordHash(keywords[i].word, strlen(keywords[i].word));
+        Assert(keywordTable[h] == NULL);
+        keywordTable[h] = &keywords[i];
+    }
+}
+
+static const Keyword *FindKeyword(const char *s, int len) {
+    if (len < MinKeywordLen || len > MaxKeywordLen) return NULL;
+    const Keyword *k = keywordTable[KeywordHash(s, len)];
+    if (k && strncmp(k->word, s, len) == 0 && k->word[len] == '\0')
+        return k;
+    return NULL;
+}
+
+
+FastScanner::FastScanner() {
+    base = cur = end = NULL;
+    atEndOfInput = true;
+    lval = NULL;
+    lloc = NULL;
+    curLineNum = curColNum = 1;
+    state = Initial;
+}
+
+void FastScanner::Init(const char *text, size_t size) {
+    // built once, by whichever thread gets here first
+    static const bool tablesBuilt = (InitCharClasses(), InitKeywords(), true);
+    base = cur = text;
+    end = text + size;
+    atEndOfInput = true;
+    curLineNum = curColNum = 1;
+    state = Initial;
+}
+
+void FastScanner::Extend(const char *text, size_t avail, bool endOfInput) {
+    cur = text + (cur - base);
+    base = text;
+    end = text + avail;
+    atEndOfInput = endOfInput;
+}
+
+/* Equivalent of DoBeforeEachAction() in scanner.l, followed by consuming
+ * the lexeme.
+ */
+void FastScanner::Lexeme(int len) {
+    lloc->first_line = curLineNum;
+    lloc->first_column = curColNum;
+    lloc->last_column = curColNum + len - 1;
+    lloc->first_offset = cur - base;
+    lloc->last_offset = lloc->first_offset + len - 1;
+    curColNum += len;
+    cur += len;
+}
+
+void FastScanner::Newline() {
+    Lexeme(1);
+    curLineNum++;
+    curColNum = 1;
+}
+
+void FastScanner::Tab() {
+    Lexeme(1);
+    curColNum += TAB_SIZE - curColNum%TAB_SIZE + 1;
+}
+
+int FastScanner::Operator(int len, int token, OpCode op) {
+    lval->opcode = op;
+    Lexeme(len);
+    return token;
+}
+
+/* Scans an identifier (or field selection) that is known to start with a
+ * letter, then checks whether it is actually a reserved word.
+ */
+int FastScanner::Word(bool fieldSelection) {
+    const char *start = cur;
+    const char *p = cur + 1;
+    while (p < end && delta[S_Ident][charClass[(unsigned char)*p]] == S_Ident)
+        p++;
+    int len = p - start;
+    Lexeme(len);
+
+    if (!fieldSelection) {
+        const Keyword *k = FindKeyword(start, len);
+        if (k && k->token == T_BoolConstant) {
+            lval->boolConstant = (start[0] == 't');
+            return T_BoolConstant;
+        }
+        if (k) return k->token;
+    }
+
+    if (len > 1023) {
+        string text(start, len);
+        ReportError::LongIdentifier(lloc, text.c_str());
+    }
+    lval->identifier = Intern(start, len < MaxIdentLen ? len : MaxIdentLen);
+    return fieldSelection ? T_FieldSelection : T_Identifier;
+}
+
+/* Runs the DFA from a digit. An identifier can never start here, so the
+ * accepting state reached says which kind of constant was read.
+ */
+int FastScanner::Number() {
+    const char *start = cur, *p = cur, *acceptEnd = cur;
+    int s = S_Start, acceptState = S_Dead;
+    while (p < end && (s = delta[s][charClass[(unsigned char)*p]]) != S_Dead) {
+        p++;
+        if (accepting[s]) {
+            acceptState = s;
+            acceptEnd = p;
+        }
+    }
+    int len = acceptEnd - start;
+    Lexeme(len);
+
+    // strtol/atof need a terminated copy; constants are nearly always short
+    char buf[64];
+    string longText;
+    const char *text = buf;
+    if (len < (int)sizeof(buf)) {
+        memcpy(buf, start, len);
+        buf[len] = '\0';
+    } else {
+        longText.assign(start, len);
+        text = longText.c_str();
+    }
+
+    switch (acceptState) {
+      case S_Hex:
+        lval->integerConstant = strtol(text, NULL, 16);
+        return T_IntConstant;
+      case S_Frac:
+      case S_FloatSuffix:
+        lval->floatConstant = atof(text);
+        return T_FloatConstant;
+      default:
+        lval->integerConstant = strtol(text, NULL, 10);
+        return T_IntConstant;
+    }
+}
+
+/* Function: Lex
+ * -------------
+ * Returns the next token code, or 0 at end of input, storing its value
+ * and location through the given pointers. The cases below
+ * follow the rule order of scanner.l so that ties resolve the same way.
+ */
+int FastScanner::Lex(union YYSTYPE *lvalp, yyltype *llocp) {
+    lval = lvalp;
+    lloc = llocp;
+    while (cur < end) {
+        unsigned char c = *cur;
+
+        if (c == '\n') { Newline(); continue; }
+        if (c == '\t') { Tab(); continue; }
+
+        if (state == Comment) {
+            if (c == '*' && cur + 1 < end && cur[1] == '/') {
+                Lexeme(2);
+                state = Initial;
+            } else
+                Lexeme(1);
+            continue;
+        }
+
+        if (state == Fields) {
+            if (charClass[c] >= C_X && charClass[c] <= C_Alpha) {
+                state = Initial;
+                return Word(true);
+            }
+            if (c != ' ' && c != '\r') // flex's default rule echoes it
+                fwrite(cur, 1, 1, OutputFile());
+            Lexeme(1);
+            continue;
+        }
+
+        char next = (cur + 1 < end ? cur[1] : '\0');
+        switch (c) {
+          case ' ': {
+            const char *p = cur;
+            while (p < end && *p == ' ') p++;
+            Lexeme(p - cur);
+            continue;
+          }
+          case '/':
+            if (next == '*') { Lexeme(2); state = Comment; continue; }
+            if (next == '/') {
+                const char *p = (const char *)memchr(cur, '\n', end - cur);
+                Lexeme((p ? p : end) - cur);
+                continue;
+            }
+            if (next == '=') return Operator(2, T_DivAssign, OP_DivAssign);
+            return Operator(1, T_Slash, OP_Div);
+
+          case '(': Lexeme(1); return T_LeftParen;
+          case ')': Lexeme(1); return T_RightParen;
+          case ':': Lexeme(1); return T_Colon;
+          case ';': Lexeme(1); return T_Semicolon;
+          case '{': Lexeme(1); return T_LeftBrace;
+          case '}': Lexeme(1); return T_RightBrace;
+          case '[': Lexeme(1); return T_LeftBracket;
+          case ']': Lexeme(1); return T_RightBracket;
+          case ',': Lexeme(1); return T_Comma;
+          case '.':
+            Lexeme(1);
+            state = Fields;
+            return T_Dot;
+
+          case '<': return next == '=' ? Operator(2, T_LessEqual, OP_LessEqual) : Operator(1, T_LeftAngle, OP_Less);
+          case '>': return next == '=' ? Operator(2, T_GreaterEqual, OP_GreaterEqual) : Operator(1, T_RightAngle, OP_Greater);
+          case '=': return next == '=' ? Operator(2, T_EQ, OP_Equal) : Operator(1, T_Equal, OP_Assign);
+          case '+':
+            if (next == '+') return Operator(2, T_Inc, OP_Inc);
+            return next == '=' ? Operator(2, T_AddAssign, OP_AddAssign) : Operator(1, T_Plus, OP_Add);
+          case '-':
+            if (next == '-') return Operator(2, T_Dec, OP_Dec);
+            return next == '=' ? Operator(2, T_SubAssign, OP_SubAssign) : Operator(1, T_Dash, OP_Sub);
+          case '*': return next == '=' ? Operator(2, T_MulAssign, OP_MulAssign) : Operator(1, T_Star, OP_Mul);
+          case '?': Lexeme(1); return T_Question;
+          case '!': if (next == '=') return Operator(2, T_NE, OP_NotEqual); break;
+          case '&': if (next == '&') return Operator(2, T_And, OP_And); break;
+          case '|': if (next == '|') return Operator(2, T_Or, OP_Or); break;
+        }
+
+        switch (charClass[c]) {
+          case C_Zero: case C_Digit:
+            return Number();
+          case C_X: case C_Hex: case C_F: case C_Alpha:
+            return Word(false);
+        }
+
+        Lexeme(1);
+        ReportError::UnrecogChar(lloc, c);
+    }
+
+    if (state == Comment && atEndOfInput) {
+        ReportError::UntermComment();
+        state = Initial;
+    }
+    return 0;
+}
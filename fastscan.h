@@ -0,0 +1,65 @@
+/* File: fastscan.h
+ * ----------------
+ * This file defines FastScanner, a hand-written alternative to the flex
+ * scanner in scanner.l. It reads the same in-memory SourceBuffer and
+ * hands the parser the same token codes, yylval values and yylloc
+ * positions, so the two engines can be swapped with --scanner=fast|flex
+ * and their output diffed.
+ *
+ * Identifiers and numeric constants are recognized by a small table-
+ * driven DFA over character classes, with longest-match backtracking
+ * just as flex does. Keywords are not separate DFA paths: an identifier
+ * is looked up in a perfect hash of the reserved words once it ends.
+ * Punctuation, comments and whitespace are dispatched on the first
+ * character. Column bookkeeping mirrors DoBeforeEachAction() lexeme for
+ * lexeme, including skipped whitespace and comment text, so that even
+ * the position of a syntax error at end of input matches.
+ *
+ * The text can also be handed over a piece at a time, as it arrives. Each
+ * piece must end just after a newline (or at the true end of input), so
+ * no token, which never spans a line, can be cut in two; only the state
+ * of a block comment carries over from one piece to the next.
+ */
+
+#ifndef _H_fastscan
+#define _H_fastscan
+
+#include <stddef.h>
+#include "location.h"
+#include "optypes.h"
+
+union YYSTYPE;
+
+class FastScanner
+{
+  protected:
+    const char *base, *cur, *end;
+    bool atEndOfInput;             // false while more text may be added
+    int curLineNum, curColNum;
+    enum { Initial, Comment, Fields } state;
+    union YYSTYPE *lval;           // where Lex() is storing this token
+    yyltype *lloc;
+
+    void Lexeme(int len);          // record yylloc for len chars at cur
+    void Newline();
+    void Tab();
+    int Operator(int len, int token, OpCode op);
+    int Word(bool fieldSelection);
+    int Number();
+
+  public:
+    FastScanner();
+
+    void Init(const char *text, size_t size);
+
+          // Streaming: text holds the input read so far, possibly moved
+          // since the last call, of which the first avail bytes may be
+          // scanned. Lex() returns 0 with NeedsInput() true when it runs
+          // out before the end of input.
+    void Extend(const char *text, size_t avail, bool endOfInput);
+    bool NeedsInput() const { return cur == end && !atEndOfInput; }
+    size_t Available() const { return end - base; }
+    int Lex(union YYSTYPE *lvalp, yyltype *llocp);
+};
+
+#endif
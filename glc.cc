@@ -0,0 +1,52 @@
+/* File: glc.cc
+ * ------------
+ * Implementation of the interface in glc.h, over a CompilationContext.
+ */
+
+#include "glc.h"
+#include "compilation.h"
+#include "parser.h"
+
+GlcCompiler::GlcCompiler()
+{
+    InitParser();
+    context = new CompilationContext(NULL);
+}
+
+GlcCompiler::~GlcCompiler()
+{
+    delete context;
+}
+
+/* Errors go into the result as they are reported rather than through
+ * ErrorFile(), and everything else said along the way, to OutputFile()
+ * or ErrorFile(), is captured for it.
+ */
+GlcResult GlcCompiler::Compile(const char *src, size_t len, const GlcOptions &options)
+{
+    PassManager *passes = context->GetPasses();
+    for (int i = 0; i < passes->NumPasses(); i++)
+        passes->SetEnabled(passes->GetPass(i)->GetName(), true);
+    if (options.disabledPass && !passes->SetEnabled(options.disabledPass, false))
+        Failure("No pass named '%s'", options.disabledPass);
+    DebugKeySet keys;
+    for (size_t i = 0; i < options.debugKeys.size(); i++)
+        keys.Set(options.debugKeys[i].c_str(), true);
+    context->SetDebugKeys(keys);
+
+    GlcResult result;
+    context->CollectDiagnostics(&result.diagnostics);
+    OutputCapture capture;
+    result.ok = (context->Compile(src, len, options.useFastScanner) == 0);
+    capture.Stop();
+    context->CollectDiagnostics(NULL);
+    result.output = capture.GetOutput();
+    result.report = capture.GetErrors();
+    return result;
+}
+
+GlcResult GlcCompile(const char *src, size_t len, const GlcOptions &options)
+{
+    static thread_local GlcCompiler compiler;
+    return compiler.Compile(src, len, options);
+}
@@ -0,0 +1,77 @@
+/* File: glc.h
+ * -----------
+ * The interface for programs that link the compiler in (libglc.a or
+ * libglc.so) rather than running glc: shader source in memory goes in,
+ * and whether it compiled, with the errors found, comes back.
+ *
+ *    GlcCompiler compiler;
+ *    GlcResult result = compiler.Compile(text, len);
+ *    for (size_t i = 0; i < result.diagnostics.size(); i++)
+ *        ... result.diagnostics[i].line, .message ...
+ *
+ * A GlcCompiler keeps what it built for one shader to build the next in:
+ * its arena, symbol table and scanner buffer are emptied, not freed, so
+ * checking the same shader over and over, as on each save, allocates
+ * next to nothing. GlcCompile() uses one kept for the calling thread.
+ * A compiler is used on one thread at a time; different compilers can be
+ * used on different threads at once.
+ */
+
+#ifndef _H_glc
+#define _H_glc
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+class CompilationContext;
+
+struct GlcOptions
+{
+    bool useFastScanner;               // the hand-written scanner, not flex
+    const char *disabledPass;          // as --disable-pass=<name>, or NULL
+    std::vector<std::string> debugKeys; // as given after -d
+
+    GlcOptions() : useFastScanner(true), disabledPass(NULL) {}
+};
+
+struct GlcDiagnostic
+{
+    int line, column;                  // where the error starts, both from 1,
+    int lastLine, lastColumn;          // and ends; all 0 if it has no place
+    std::string message;               // as glc prints it after "*** "
+};
+
+struct GlcResult
+{
+    bool ok;                           // whether there were no errors
+    std::vector<GlcDiagnostic> diagnostics; // in the order found
+    std::string output;                // what glc would print on stdout
+    std::string report;                // and on stderr besides the errors:
+                                       // the tables -d timePasses and
+                                       // -d allocstats ask for
+};
+
+class GlcCompiler
+{
+    CompilationContext *context;
+
+  public:
+    GlcCompiler();
+    ~GlcCompiler();
+
+          // Compiles len bytes of shader source, which need not be
+          // terminated. Fails (see Failure() in utility.h) only if
+          // options.disabledPass names no pass, or memory runs out.
+    GlcResult Compile(const char *src, size_t len,
+                      const GlcOptions &options = GlcOptions());
+
+  private:
+    GlcCompiler(const GlcCompiler &);
+    GlcCompiler &operator=(const GlcCompiler &);
+};
+
+GlcResult GlcCompile(const char *src, size_t len,
+                     const GlcOptions &options = GlcOptions());
+
+#endif
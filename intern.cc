@@ -0,0 +1,103 @@
+/* File: intern.cc
+ * ---------------
+ * Implementation of the string interner: an open-addressing hash set of
+ * pointers into bump-allocated character blocks.
+ *
+ * Scanners on several threads intern at once, so the pool is split into
+ * shards selected by the top bits of the hash, each with its own table,
+ * block and lock. A given string always hashes to the same shard, which
+ * keeps the answer canonical across threads while unrelated names rarely
+ * contend for the same lock.
+ */
+
+#include "intern.h"
+#include "utility.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <mutex>
+
+struct InternEntry {
+    const char *str;   // NULL if the slot is empty
+    uint32_t hash;
+    uint32_t len;
+};
+
+static const size_t BlockSize = 64 * 1024;
+static const uint32_t InitialSlots = 128; // per shard, a power of two
+
+static const int ShardBits = 4;
+
+struct InternShard {
+    std::mutex lock;
+    InternEntry *slots;
+    uint32_t numSlots, numUsed;
+    char *block;                    // current block being filled
+    size_t blockLeft;
+};
+
+static InternShard shards[1 << ShardBits];
+
+static uint32_t HashString(const char *s, size_t len) {
+    uint32_t h = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* Copies the text into the current block, starting a new one if it does
+ * not fit. Strings longer than a block get a block to themselves.
+ */
+static const char *StoreString(InternShard &sh, const char *s, size_t len) {
+    if (len + 1 > sh.blockLeft) {
+        size_t size = (len + 1 > BlockSize ? len + 1 : BlockSize);
+        sh.block = (char *)malloc(size);
+        if (!sh.block) Failure("Out of memory interning identifiers");
+        sh.blockLeft = size;
+    }
+    char *copy = sh.block;
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    sh.block += len + 1;
+    sh.blockLeft -= len + 1;
+    return copy;
+}
+
+static void Rehash(InternShard &sh, uint32_t newSize) {
+    InternEntry *old = sh.slots;
+    uint32_t oldSize = sh.numSlots;
+    sh.slots = (InternEntry *)calloc(newSize, sizeof(InternEntry));
+    if (!sh.slots) Failure("Out of memory interning identifiers");
+    sh.numSlots = newSize;
+    for (uint32_t i = 0; i < oldSize; i++) {
+        if (!old[i].str) continue;
+        uint32_t j = old[i].hash & (sh.numSlots - 1);
+        while (sh.slots[j].str) j = (j + 1) & (sh.numSlots - 1);
+        sh.slots[j] = old[i];
+    }
+    free(old);
+}
+
+const char *Intern(const char *s, size_t len) {
+    uint32_t h = HashString(s, len);
+    InternShard &sh = shards[h >> (32 - ShardBits)];
+    std::lock_guard<std::mutex> guard(sh.lock);
+
+    if (sh.numUsed * 2 >= sh.numSlots) // keep the load factor under one half
+        Rehash(sh, sh.numSlots ? sh.numSlots * 2 : InitialSlots);
+
+    uint32_t mask = sh.numSlots - 1;
+    uint32_t i = h & mask;
+    for (; sh.slots[i].str; i = (i + 1) & mask) {
+        if (sh.slots[i].hash == h && sh.slots[i].len == len &&
+            memcmp(sh.slots[i].str, s, len) == 0)
+            return sh.slots[i].str;
+    }
+
+    sh.slots[i].str = StoreString(sh, s, len);
+    sh.slots[i].hash = h;
+    sh.slots[i].len = len;
+    sh.numUsed++;
+    return sh.slots[i].str;
+}
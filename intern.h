@@ -0,0 +1,32 @@
+/* File: intern.h
+ * --------------
+ * This file declares the string interner used for identifier names.
+ * Interning a string returns a canonical copy of it: two calls with equal
+ * text return the same pointer. Names can therefore be compared, hashed
+ * and ordered by address instead of with strcmp, and the scanner can hand
+ * every occurrence of an identifier to the parser without allocating.
+ *
+ * Interned strings are NUL-terminated, packed into large blocks that are
+ * never freed, and stay valid for the life of the process.
+ */
+
+#ifndef _H_intern
+#define _H_intern
+
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * Function: Intern()
+ * Usage: const char *atom = Intern(yytext, yyleng);
+ * -------------------------------------------------
+ * Returns the canonical copy of the first len characters of s, adding
+ * it to the pool if this is the first time that text has been seen. The
+ * text need not be NUL-terminated. Safe to call from any thread.
+ */
+
+const char *Intern(const char *s, size_t len);
+
+inline const char *Intern(const char *s) { return Intern(s, strlen(s)); }
+
+#endif
@@ -3,8 +3,11 @@
  * ------------
  * Simple list class for storing a linear collection of elements. It
  * supports operations similar in name to the CS107 CVector -- nth, insert,
- * append, remove, etc.  This class is nothing more than a very thin
- * cover of a STL deque, with some added range-checking. Given not everyone
+ * append, remove, etc.  It is a small vector: the elements are kept in
+ * one contiguous array, the first few of them inside the List itself, so
+ * the short lists that make up most of the AST (arguments, formals, the
+ * statements of a block) need no further allocation. Longer lists spill
+ * into storage from the current Arena, if any. Given not everyone
  * is familiar with the C++ templates, this class provides a more familiar
  * interface.
  *
@@ -23,13 +26,19 @@
  *       }
  *       return sum;
  *    }
+ *
+ * or, equivalently, with a range-based for loop over the list:
+ *
+ *       for (int val : *list) sum += val;
  */
 
 #ifndef _H_list
 #define _H_list
 
-#include <deque>
+#include <new>
+#include <utility>
 #include "utility.h"  // for Assert()
+#include "arena.h"
 using namespace std;
 
 class Node;
@@ -37,15 +46,85 @@ class Node;
 template<class Element> class List {
 
  private:
-    deque<Element> elems;
+    static const int InlineCapacity = 4;
+
+    Element *elems;          // inlineElems until the list outgrows it
+    int numElems, capacity;
+    alignas(Element) char inlineElems[InlineCapacity * sizeof(Element)];
+
+    bool IsInline() const { return elems == (Element *)inlineElems; }
+
+          // Moves the elements into a larger array from the arena. The old
+          // array is left behind; the arena reclaims it with everything else.
+    void Grow(int minCapacity) {
+        int newCapacity = capacity * 2;
+        if (newCapacity < minCapacity) newCapacity = minCapacity;
+        Element *bigger = (Element *)ArenaAllocate(newCapacity * sizeof(Element));
+        for (int i = 0; i < numElems; i++) {
+            new (&bigger[i]) Element(std::move(elems[i]));
+            elems[i].~Element();
+        }
+        elems = bigger;
+        capacity = newCapacity;
+    }
+
+    void Clear() {
+        for (int i = 0; i < numElems; i++) elems[i].~Element();
+        numElems = 0;
+    }
+
+    void TakeFrom(List &other) {
+        if (other.IsInline()) {
+            for (int i = 0; i < other.numElems; i++)
+                new (&elems[i]) Element(std::move(other.elems[i]));
+            numElems = other.numElems;
+            other.Clear();
+        } else {
+            elems = other.elems;
+            numElems = other.numElems;
+            capacity = other.capacity;
+            other.elems = (Element *)other.inlineElems;
+            other.numElems = 0;
+            other.capacity = InlineCapacity;
+        }
+    }
 
  public:
            // Create a new empty list
-    List() {}
+    List() : elems((Element *)inlineElems), numElems(0), capacity(InlineCapacity) {}
+
+    List(const List &other) : List() {
+        for (int i = 0; i < other.numElems; i++) Append(other.elems[i]);
+    }
+    List(List &&other) : List() { TakeFrom(other); }
+
+    List &operator=(const List &other) {
+        if (this != &other) {
+            Clear();
+            for (int i = 0; i < other.numElems; i++) Append(other.elems[i]);
+        }
+        return *this;
+    }
+    List &operator=(List &&other) {
+        if (this != &other) {
+            Clear();
+            elems = (Element *)inlineElems;
+            capacity = InlineCapacity;
+            TakeFrom(other);
+        }
+        return *this;
+    }
+
+    ~List() { Clear(); }
+
+           // Like the nodes that hold them, lists and their elements
+           // live in the current arena
+    void *operator new(size_t size) { return ArenaAllocate(size); }
+    void operator delete(void *) {}
 
            // Returns count of elements currently in list
     int NumElements() const
-	{ return elems.size(); }
+	{ return numElems; }
 
           // Returns element at index in list. Indexing is 0-based.
           // Raises an assert if index is out of range.
@@ -57,17 +136,41 @@ template<class Element> class List {
           // Raises assert if index out of range
     void InsertAt(const Element &elem, int index)
 	{ Assert(index >= 0 && index <= NumElements());
-	  elems.insert(elems.begin() + index, elem); }
+	  Element copy(elem);  // elem may live in this list
+	  if (numElems == capacity) Grow(numElems + 1);
+	  if (index == numElems) {
+	      new (&elems[numElems]) Element(std::move(copy));
+	  } else {
+	      new (&elems[numElems]) Element(std::move(elems[numElems - 1]));
+	      for (int i = numElems - 1; i > index; i--)
+	          elems[i] = std::move(elems[i - 1]);
+	      elems[index] = std::move(copy);
+	  }
+	  numElems++; }
 
           // Adds element to list end
     void Append(const Element &elem)
-	{ elems.push_back(elem); }
+	{ if (numElems == capacity) {
+	      Element copy(elem);  // elem may live in this list
+	      Grow(numElems + 1);
+	      new (&elems[numElems++]) Element(std::move(copy));
+	  } else {
+	      new (&elems[numElems++]) Element(elem);
+	  } }
 
          // Removes element at index, shuffling down others
          // Raises assert if index out of range
     void RemoveAt(int index)
 	{ Assert(index >= 0 && index < NumElements());
-	  elems.erase(elems.begin() + index); }
+	  for (int i = index; i < numElems - 1; i++)
+	      elems[i] = std::move(elems[i + 1]);
+	  elems[--numElems].~Element(); }
+
+          // Iteration over the elements in order, for range-based for
+    Element *begin() { return elems; }
+    Element *end() { return elems + numElems; }
+    const Element *begin() const { return elems; }
+    const Element *end() const { return elems + numElems; }
           
        // These are some specific methods useful for lists of ast nodes
        // They will only work on lists of elements that respond to the
@@ -76,13 +179,12 @@ template<class Element> class List {
        // don't try to SetParentAll on that list.
     void SetParentAll(Node *p)
         { for (int i = 0; i < NumElements(); i++)
-             Nth(i)->SetParent(p); }
+             elems[i]->SetParent(p); }
     void PrintAll(int indentLevel, const char *label = NULL)
         { for (int i = 0; i < NumElements(); i++)
-             Nth(i)->Print(indentLevel, label); }
+             elems[i]->Print(indentLevel, label); }
              
 
 };
 
 #endif
-
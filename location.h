@@ -2,35 +2,52 @@
  * ----------------
  * This file just contains features relative to the location structure
  * used to record the lexical position of a token or symbol.  This file
- * establishes the cmoon definition for the yyltype structure, the global
- * variable yylloc, and a utility function to join locations you might
- * find handy at times.
+ * establishes the cmoon definition for the yyltype structure, the compact
+ * SourceRange kept in AST nodes, and a utility function to join locations
+ * you might find handy at times. There is no global yylloc: the parser is
+ * pure, so the location of the lookahead token lives in each call to
+ * yyparse() and yylex() fills it through a pointer.
  */
 
 #ifndef YYLTYPE
 
+#include <stdint.h>
+
 /* Typedef: yyltype
  * ----------------
  * Defines the struct type that is used by the scanner to store
- * position information about each lexeme scanned.
+ * position information about each lexeme scanned. Besides the line and
+ * columns, it records the byte offsets of the first and last characters
+ * in the source text, which is all an AST node keeps.
  */
 typedef struct yyltype
 {
-    int timestamp;                 // you can ignore this field
     int first_line, first_column;
-    int last_line, last_column;      
-    char *text;                    // you can also ignore this field
+    int last_line, last_column;
+    uint32_t first_offset, last_offset;
 } yyltype;
 
 #define YYLTYPE yyltype
 
 
-/* Global variable: yylloc
- * ------------------------
- * The global variable holding the position information about the
- * lexeme just scanned.
+/* Struct: SourceRange
+ * -------------------
+ * The location of an AST node: the offsets of its first and last
+ * characters, stored inline in the node. Lines and columns are worked
+ * out from the source buffer's line table only when they are needed, by
+ * ExpandRange() in the scanner. Nodes that have no place in the source
+ * (the built-in types, for instance) have an invalid range.
  */
-extern struct yyltype yylloc;
+struct SourceRange
+{
+    uint32_t first, last;
+
+    SourceRange() : first(UINT32_MAX), last(UINT32_MAX) {}
+    SourceRange(uint32_t f, uint32_t l) : first(f), last(l) {}
+    SourceRange(const yyltype &loc) : first(loc.first_offset), last(loc.last_offset) {}
+
+    bool IsValid() const { return first != UINT32_MAX; }
+};
 
 
 /* Function: Join
@@ -38,22 +55,10 @@ extern struct yyltype yylloc;
  * Takes two locations and returns a new location which represents
  * the span from first to last, inclusive.
  */
-inline yyltype Join(yyltype first, yyltype last)
+inline SourceRange Join(SourceRange first, SourceRange last)
 {
-  yyltype combined;
-  combined.first_column = first.first_column;
-  combined.first_line = first.first_line;
-  combined.last_column = last.last_column;
-  combined.last_line = last.last_line;
-  return combined;
-}
-
-/* Same as above, except operates on pointers as a convenience  */
-inline yyltype Join(yyltype *firstPtr, yyltype *lastPtr)
-{
-  return Join(*firstPtr, *lastPtr);
+  return SourceRange(first.first, last.last);
 }
 
 
 #endif
-
@@ -6,25 +6,178 @@
  
 #include <string.h>
 #include <stdio.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
 #include "utility.h"
-#include "errors.h"
 #include "parser.h"
+#include "compilation.h"
+#include "threadpool.h"
+
+
+/* Function: Compile()
+ * -------------------
+ * Compiles one shader, read from the named file or from stdin if path is
+ * NULL, in a context of its own (see compilation.h), and returns 0 if it
+ * had no errors or -1 if it did. Given a pool, the functions in it are
+ * checked on the pool's threads.
+ */
+static int Compile(const char *path, ThreadPool *pool)
+{
+    CompilationContext context(pool);
+    const char *disabled = GetOption("disable-pass");
+    if (disabled && !context.GetPasses()->SetEnabled(disabled, false))
+        Failure("No pass named '%s'", disabled);
+    return context.Compile(path);
+}
+
+
+// Whether a file in a directory given to --batch is a shader to compile
+static bool IsShaderName(const std::string &name)
+{
+    size_t dot = name.rfind('.');
+    if (dot == std::string::npos) return false;
+    return name.compare(dot, std::string::npos, ".glsl") == 0 ||
+           name.compare(dot, std::string::npos, ".frag") == 0;
+}
+
+/* Function: CollectInputs()
+ * -------------------------
+ * Adds the files to compile that a --batch argument names: a file stands
+ * for itself, a directory for the .glsl and .frag files anywhere under
+ * it, in name order, and @list for whatever is named in the file list,
+ * one to a line (blank lines and lines starting with # are skipped).
+ */
+static void CollectInputs(const std::string &arg, std::vector<std::string> *paths)
+{
+    if (arg[0] == '@') {
+        std::ifstream list(arg.c_str() + 1);
+        if (!list)
+            Failure("Unable to read input list %s", arg.c_str() + 1);
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty() && line[line.size()-1] == '\r')
+                line.erase(line.size()-1);
+            if (!line.empty() && line[0] != '#')
+                CollectInputs(line, paths);
+        }
+        return;
+    }
+
+    struct stat st;
+    if (stat(arg.c_str(), &st) != 0)
+        Failure("Unable to read input file %s", arg.c_str());
+    if (!S_ISDIR(st.st_mode)) {
+        paths->push_back(arg);
+        return;
+    }
+    DIR *dir = opendir(arg.c_str());
+    if (!dir)
+        Failure("Unable to read directory %s", arg.c_str());
+    std::vector<std::string> names;
+    while (struct dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] != '.')
+            names.push_back(entry->d_name);
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    std::string prefix = (arg[arg.size()-1] == '/' ? arg : arg + "/");
+    for (size_t i = 0; i < names.size(); i++) {
+        std::string path = prefix + names[i];
+        if (stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+            CollectInputs(path, paths);
+        else if (IsShaderName(names[i]))
+            paths->push_back(path);
+    }
+}
+
+
+/* Function: CompileBatch()
+ * ------------------------
+ * Compiles every input named on the command line (see CollectInputs) in
+ * this one process, spread over --jobs=<n> threads, one per core by
+ * default. Each compilation's output and errors are collected as it
+ * runs and written out under the name of its file, one file after
+ * another in the order they were named, whichever thread got to each one
+ * first. Returns 0 if none of them had errors, or -1 if any did.
+ */
+static int CompileBatch()
+{
+    std::vector<std::string> paths;
+    for (int i = 0; i < NumInputPaths(); i++)
+        CollectInputs(GetInputPath(i), &paths);
+    if (paths.empty())
+        Failure("Nothing to compile: --batch needs files, directories or @lists");
+    const char *jobs = GetOption("jobs");
+
+    struct Output {
+        OutputCapture *capture;   // set once the file has been compiled
+        int status;
+    };
+    std::vector<Output> outputs(paths.size());
+    std::mutex lock;
+    std::condition_variable finished;
+
+    ThreadPool pool(jobs ? atoi(jobs) : 0);
+    for (size_t i = 0; i < paths.size(); i++) {
+        pool.Submit([&, i] {
+            OutputCapture *capture = new OutputCapture;
+            int status = Compile(paths[i].c_str(), NULL);
+            capture->Stop();
+            std::lock_guard<std::mutex> hold(lock);
+            outputs[i].capture = capture;
+            outputs[i].status = status;
+            finished.notify_all();
+        });
+    }
+
+    // write each one out as soon as it and all those before it are done
+    int failed = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        Output output;
+        {
+            std::unique_lock<std::mutex> hold(lock);
+            finished.wait(hold, [&] { return outputs[i].capture != NULL; });
+            output = outputs[i];
+        }
+        printf("%s\n", paths[i].c_str());
+        output.capture->Replay();
+        delete output.capture;
+        if (output.status != 0)
+            failed++;
+    }
+    pool.Wait();
+    fflush(stdout);
+    if (failed)
+        fprintf(stderr, "%d of %zu files had errors\n", failed, paths.size());
+    return (failed == 0? 0 : -1);
+}
 
 
 /* Function: main()
  * ----------------
  * Entry point to the entire program.  We parse the command line and turn
  * on any debugging flags requested by the user when invoking the program.
- * InitScanner() is used to set up the scanner.
- * InitParser() is used to set up the parser. The call to yyparse() will
- * attempt to parse a complete program from the input. 
+ * InitParser() is used to set up the parser. Then we compile the file
+ * named on the command line or stdin, or with --batch, all the files
+ * named there. Given --jobs=<n> for a single file, its functions are
+ * checked on n threads (0 for one per core).
  */
 int main(int argc, char *argv[])
 {
     ParseCommandLine(argc, argv);
-    InitScanner();
     InitParser();
-    yyparse();
-    return (ReportError::NumErrors() == 0? 0 : -1);
+    if (GetOption("batch"))
+        return CompileBatch();
+    const char *jobs = GetOption("jobs");
+    if (jobs) {
+        ThreadPool pool(atoi(jobs));
+        return Compile(GetInputPath(), &pool);
+    }
+    return Compile(GetInputPath(), NULL);
 }
-
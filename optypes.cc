@@ -0,0 +1,145 @@
+/* File: optypes.cc
+ * ----------------
+ * The operator typing table and the rules it is built from.
+ */
+
+#include <stdint.h>
+#include "optypes.h"
+#include "ast_type.h"
+
+static const uint8_t Invalid = 0xff;
+
+static constexpr bool IsScalar(int t) {
+    return t == BT_Bool || t == BT_Int || t == BT_Uint || t == BT_Float;
+}
+
+static constexpr bool IsVector(int t) {
+    return t >= BT_Vec2 && t <= BT_UVec4;
+}
+
+static constexpr bool IsMatrix(int t) {
+    return t >= BT_Mat2 && t <= BT_Mat4;
+}
+
+// The scalar a built-in is made of: itself for a scalar, float for a matrix
+static constexpr int ScalarOf(int t) {
+    return IsScalar(t) ? t :
+           (t >= BT_Vec2 && t <= BT_Vec4) || IsMatrix(t) ? BT_Float :
+           (t >= BT_IVec2 && t <= BT_IVec4) ? BT_Int :
+           (t >= BT_BVec2 && t <= BT_BVec4) ? BT_Bool :
+           (t >= BT_UVec2 && t <= BT_UVec4) ? BT_Uint : Invalid;
+}
+
+static constexpr int ColumnOf(int mat) {
+    return BT_Vec2 + (mat - BT_Mat2);
+}
+
+static constexpr bool IsNumeric(int t) {
+    return ScalarOf(t) == BT_Int || ScalarOf(t) == BT_Uint || ScalarOf(t) == BT_Float;
+}
+
+// + - / component-wise, and * also as a matrix product when linear is set
+static constexpr int Arithmetic(int l, int r, bool linear) {
+    return !IsNumeric(l) || !IsNumeric(r) ? Invalid :
+           l == r ? l :
+           IsScalar(l) && ScalarOf(r) == l ? r :
+           IsScalar(r) && ScalarOf(l) == r ? l :
+           linear && IsMatrix(l) && r == ColumnOf(l) ? r :
+           linear && IsMatrix(r) && l == ColumnOf(r) ? l : Invalid;
+}
+
+static constexpr int CompoundAssign(int l, int r, bool linear) {
+    return Arithmetic(l, r, linear) == l ? l : Invalid;
+}
+
+static constexpr int Binary(int op, int l, int r) {
+    return l == BT_Error && r == BT_Error ? BT_Error :
+           !IsScalar(l) && !IsVector(l) && !IsMatrix(l) ? Invalid :
+           !IsScalar(r) && !IsVector(r) && !IsMatrix(r) ? Invalid :
+           op == OP_Add || op == OP_Sub || op == OP_Div ? Arithmetic(l, r, false) :
+           op == OP_Mul ? Arithmetic(l, r, true) :
+           op == OP_AddAssign || op == OP_SubAssign || op == OP_DivAssign ?
+               CompoundAssign(l, r, false) :
+           op == OP_MulAssign ? CompoundAssign(l, r, true) :
+           op == OP_Assign ? (l == r ? l : Invalid) :
+           op == OP_Equal || op == OP_NotEqual ? (l == r ? BT_Bool : Invalid) :
+           op == OP_Less || op == OP_Greater || op == OP_LessEqual || op == OP_GreaterEqual ?
+               (l == r && IsScalar(l) && IsNumeric(l) ? BT_Bool : Invalid) :
+           op == OP_And || op == OP_Or ? (l == BT_Bool && r == BT_Bool ? BT_Bool : Invalid) :
+           Invalid;
+}
+
+static constexpr int Unary(int op, int t) {
+    return t == BT_Error ? BT_Error :
+           (op == OP_Add || op == OP_Sub || op == OP_Inc || op == OP_Dec) && IsNumeric(t) ? t :
+           Invalid;
+}
+
+struct OperatorTable {
+    uint8_t binary[NumOpCodes][NumBuiltinTypes][NumBuiltinTypes];
+    uint8_t unary[NumOpCodes][NumBuiltinTypes];
+
+    constexpr OperatorTable() : binary(), unary() {
+        for (int op = 0; op < NumOpCodes; op++) {
+            for (int l = 0; l < NumBuiltinTypes; l++) {
+                unary[op][l] = Unary(op, l);
+                for (int r = 0; r < NumBuiltinTypes; r++)
+                    binary[op][l][r] = Binary(op, l, r);
+            }
+        }
+    }
+};
+
+static constexpr OperatorTable table;
+
+static_assert(table.binary[OP_Mul][BT_Mat4][BT_Vec4] == BT_Vec4, "mat4 * vec4");
+static_assert(table.binary[OP_Mul][BT_Vec3][BT_Float] == BT_Vec3, "vec3 * float");
+static_assert(table.binary[OP_Add][BT_Mat2][BT_Vec2] == Invalid, "mat2 + vec2");
+static_assert(table.binary[OP_MulAssign][BT_Vec4][BT_Mat4] == BT_Vec4, "vec4 *= mat4");
+static_assert(table.binary[OP_MulAssign][BT_Mat4][BT_Vec4] == Invalid, "mat4 *= vec4");
+
+static const char *const spellings[NumOpCodes] = {
+    "+", "-", "*", "/",
+    "++", "--",
+    "<", ">", "<=", ">=",
+    "==", "!=",
+    "&&", "||",
+    "=", "+=", "-=", "*=", "/=",
+};
+
+const char *OpSpelling(OpCode op) {
+    return spellings[op];
+}
+
+bool IsComparisonOrLogical(OpCode op) {
+    switch (op) {
+      case OP_Less: case OP_Greater: case OP_LessEqual: case OP_GreaterEqual:
+      case OP_Equal: case OP_NotEqual:
+      case OP_And: case OP_Or:
+        return true;
+      default:
+        return false;
+    }
+}
+
+/* Types other than the built-ins (arrays) can only be assigned and
+ * compared, and only with the very same type.
+ */
+Type *BinaryResultType(OpCode op, Type *lhs, Type *rhs) {
+    BuiltinType l = lhs->GetBuiltin(), r = rhs->GetBuiltin();
+    if (l == BT_Other || r == BT_Other) {
+        if (!lhs->IsEquivalentTo(rhs)) return NULL;
+        if (op == OP_Assign) return lhs;
+        if (op == OP_Equal || op == OP_NotEqual) return Type::boolType;
+        return NULL;
+    }
+    uint8_t result = table.binary[op][l][r];
+    return result == Invalid ? NULL : Type::Get((BuiltinType)result);
+}
+
+Type *UnaryResultType(OpCode op, Type *operand) {
+    BuiltinType t = operand->GetBuiltin();
+    if (t == BT_Other) return NULL;
+    uint8_t result = table.unary[op][t];
+    return result == Invalid ? NULL : Type::Get((BuiltinType)result);
+}
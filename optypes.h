@@ -0,0 +1,42 @@
+/* File: optypes.h
+ * ---------------
+ * The typing rules for the operators. Which operand types an operator
+ * accepts, and the type of the result, come from a table indexed by the
+ * operator and the built-in types of its operands, computed entirely at
+ * compile time. It follows GLSL: arithmetic works component-wise between
+ * equal types or between a scalar and a vector or matrix of that scalar,
+ * and * also does linear algebra, so mat4 * vec4 and vec4 * mat4 are both
+ * vec4. An operand of type error yields no complaint when the other one
+ * is an error too, since that mistake has been reported already.
+ */
+
+#ifndef _H_optypes
+#define _H_optypes
+
+class Type;
+
+enum OpCode {
+    OP_Add, OP_Sub, OP_Mul, OP_Div,
+    OP_Inc, OP_Dec,
+    OP_Less, OP_Greater, OP_LessEqual, OP_GreaterEqual,
+    OP_Equal, OP_NotEqual,
+    OP_And, OP_Or,
+    OP_Assign, OP_AddAssign, OP_SubAssign, OP_MulAssign, OP_DivAssign,
+    NumOpCodes
+};
+
+// The operator as it is written, e.g. "+=" for OP_AddAssign
+const char *OpSpelling(OpCode op);
+
+// Whether the operator yields bool whatever its operand types
+bool IsComparisonOrLogical(OpCode op);
+
+/* Function: BinaryResultType(), UnaryResultType()
+ * -----------------------------------------------
+ * The type of applying op to operands of the given types, or NULL if it
+ * does not apply to them.
+ */
+Type *BinaryResultType(OpCode op, Type *lhs, Type *rhs);
+Type *UnaryResultType(OpCode op, Type *operand);
+
+#endif
@@ -17,6 +17,8 @@
 #include "ast_decl.h"
 #include "ast_expr.h"
 #include "ast_stmt.h"
+#include "ast_flat.h"
+#include "passes.h"
 
  
 // Next, we want to get the exported defines for the token codes and
@@ -28,11 +30,37 @@
 // we are compiling y.tab.c, which we use the YYBISON symbol for. 
 // Managing C headers can be such a mess! 
 
+/* Class: ParseResult
+ * -------------------
+ * What a parse produces, passed to yyparse() alongside the ScanContext:
+ * the parse tree, and its flat form (see ast_flat.h), which the grammar
+ * actions lay down row by row as they make the nodes and which the passes
+ * then run over. When passes is set, each top-level declaration is run
+ * through those passes (see passes.h) as soon as it has been parsed
+ * instead of the caller checking the whole program at the end, so
+ * diagnostics for the start of a long input come out while the rest of it
+ * is still arriving.
+ */
+class ParseResult
+{
+  public:
+    Program *program;     // set once the whole input has been parsed
+    PassManager *passes;  // to check each declaration with, or NULL
+    int checkErrors;      // errors reported by those checks
+    FlatTree tree;
+    FlatBuilder flat;     // adding to tree
+
+    ParseResult() : program(NULL), passes(NULL), checkErrors(0), flat(&tree) {}
+};
+
+class ScanContext;
+
 #ifndef YYBISON                 
 #include "y.tab.h"              
 #endif
 
-int yyparse();              // Defined in the generated y.tab.c file
+int yyparse(ScanContext *scanner, ParseResult *result); // Defined in the generated y.tab.c file
 void InitParser();          // Defined in parser.y
+void ParseStream(ScanContext *scanner, ParseResult *result, PassManager *passes); // ditto
 
 #endif
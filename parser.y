@@ -20,10 +20,49 @@
 #include "parser.h"
 #include "errors.h"
 
-void yyerror(const char *msg); // standard error-handling routine
+// standard error-handling routine, given the parse parameters as well
+void yyerror(yyltype *loc, ScanContext *scanner, ParseResult *result,
+             const char *msg);
+
+static void DeclParsed(ParseResult *result, Decl *decl);
+template<class T> static T *Flat(ParseResult *result, T *node);
+
+// as bison's default, but carrying the source offsets along as well
+#define YYLLOC_DEFAULT(Current, Rhs, N)                                 \
+    do {                                                                \
+      if (N) {                                                          \
+          (Current).first_line   = YYRHSLOC(Rhs, 1).first_line;         \
+          (Current).first_column = YYRHSLOC(Rhs, 1).first_column;       \
+          (Current).first_offset = YYRHSLOC(Rhs, 1).first_offset;       \
+          (Current).last_line    = YYRHSLOC(Rhs, N).last_line;          \
+          (Current).last_column  = YYRHSLOC(Rhs, N).last_column;        \
+          (Current).last_offset  = YYRHSLOC(Rhs, N).last_offset;        \
+      } else {                                                          \
+          (Current).first_line   = (Current).last_line   =              \
+            YYRHSLOC(Rhs, 0).last_line;                                 \
+          (Current).first_column = (Current).last_column =              \
+            YYRHSLOC(Rhs, 0).last_column;                               \
+          (Current).first_offset = (Current).last_offset =              \
+            YYRHSLOC(Rhs, 0).last_offset;                               \
+      }                                                                 \
+    } while (0)
 
 %}
 
+/* The parser is pure: the lookahead's yylval and yylloc are locals of
+ * yyparse() rather than globals, and yylex() is handed pointers to them
+ * along with the ScanContext it should read from. The finished Program
+ * is stored in the ParseResult, so nothing is shared between two parses
+ * running at once. Besides yyparse(), which pulls tokens from yylex(),
+ * there is a push interface that is handed one token at a time; see
+ * ParseStream().
+ */
+%define api.pure full
+%define api.push-pull both
+%locations
+%parse-param { ScanContext *scanner } { ParseResult *result }
+%lex-param   { ScanContext *scanner }
+
 /* The section before the first %% is the Definitions section of the yacc
  * input file. Here is where you declare tokens and types, add precedence
  * and associativity options, and so on.
@@ -42,7 +81,8 @@ void yyerror(const char *msg); // standard error-handling routine
     int integerConstant;
     bool boolConstant;
     double floatConstant;
-    char identifier[MaxIdentLen+1]; // +1 for terminating null
+    const char *identifier;   // interned, at most MaxIdentLen chars
+    OpCode opcode;
     Decl *decl;
     FnDecl *funcDecl;
     List<Decl*> *declList;
@@ -75,12 +115,12 @@ void yyerror(const char *msg); // standard error-handling routine
 %token   T_LeftParen T_RightParen T_LeftBracket T_RightBracket T_LeftBrace T_RightBrace
 %token   T_Dot T_Comma T_Colon T_Semicolon T_Question
 
-%token   <identifier> T_LessEqual T_GreaterEqual T_EQ T_NE
-%token   <identifier> T_And T_Or 
-%token   <identifier> T_Plus T_Star
-%token   <identifier> T_MulAssign T_DivAssign T_AddAssign T_SubAssign T_Equal
-%token   <identifier> T_LeftAngle T_RightAngle T_Dash T_Slash
-%token   <identifier> T_Inc T_Dec 
+%token   <opcode> T_LessEqual T_GreaterEqual T_EQ T_NE
+%token   <opcode> T_And T_Or 
+%token   <opcode> T_Plus T_Star
+%token   <opcode> T_MulAssign T_DivAssign T_AddAssign T_SubAssign T_Equal
+%token   <opcode> T_LeftAngle T_RightAngle T_Dash T_Slash
+%token   <opcode> T_Inc T_Dec 
 %token   <identifier> T_Identifier
 %token   <integerConstant> T_IntConstant
 %token   <floatConstant> T_FloatConstant
@@ -133,23 +173,14 @@ void yyerror(const char *msg); // standard error-handling routine
 	 
  */
 Program   :    DeclList            { 
-                                      @1; 
-                                      /* pp2: The @1 is needed to convince 
-                                       * yacc to set up yylloc. You can remove 
-                                       * it once you have other uses of @n*/
-                                      Program *program = new Program($1);
-                                      // if no errors, advance to next phase
-                                      if (ReportError::NumErrors() == 0) {
-                                          if ( IsDebugOn("dumpAST") ) {
-                                            program->Print(0);
-                                          }
-                                          program->Check();
-                                      }
+                                      // checking is left to the caller,
+                                      // once the parse has finished
+                                      result->program = Flat(result, new Program($1));
                                     }
           ;
 
-DeclList  :    DeclList Decl        { ($$=$1)->Append($2); }
-          |    Decl                 { ($$ = new List<Decl*>)->Append($1); }
+DeclList  :    DeclList Decl        { ($$=$1)->Append($2); DeclParsed(result, $2); }
+          |    Decl                 { ($$ = new List<Decl*>)->Append($1); DeclParsed(result, $1); }
           ;
 
 /* combine external_declaration and function_definition into a single rule
@@ -161,7 +192,7 @@ DeclList  :    DeclList Decl        { ($$=$1)->Append($2); }
  */
    
 Decl      :    Declaration                   { $$ = $1; }
-          |    FuncDecl CompoundStatement    { $1->SetFunctionBody($2); $$ = $1; }
+          |    FuncDecl CompoundStatement    { $1->SetFunctionBody($2); $$ = Flat(result, $1); }
           ;
 
 /* combine declaration and init_decl_list into a single rule
@@ -172,7 +203,7 @@ Decl      :    Declaration                   { $$ = $1; }
  *       single_declaration
  */
 
-Declaration : FuncDecl T_Semicolon   { $$ = $1; }
+Declaration : FuncDecl T_Semicolon   { $$ = Flat(result, $1); }
             | SingleDecl T_Semicolon { $$ = $1; }
             ;
 
@@ -196,33 +227,33 @@ ParameterList : SingleDecl { ($$ = new List<VarDecl *>)->Append($1);  }
 SingleDecl    : TypeDecl T_Identifier
                          {
                             Identifier *id = new Identifier(yylloc, (const char *)$2); 
-                            $$ = new VarDecl(id, $1);
+                            $$ = Flat(result, new VarDecl(id, $1));
                          }
               | TypeQualify TypeDecl T_Identifier
                          {
                             Identifier *id = new Identifier(yylloc, (const char *)$3); 
-                            $$ = new VarDecl(id, $2, $1);
+                            $$ = Flat(result, new VarDecl(id, $2, $1));
                          }
               | TypeDecl T_Identifier T_Equal Initializer
                          {
                             // incomplete: drop the initializer here
                             Identifier *id = new Identifier(yylloc, (const char *)$2); 
-                            $$ = new VarDecl(id, $1, $4);
+                            $$ = Flat(result, new VarDecl(id, $1, $4));
                          }
               | TypeQualify TypeDecl T_Identifier T_Equal Initializer
                          {
                             Identifier *id = new Identifier(yylloc, (const char *)$3); 
-                            $$ = new VarDecl(id, $2, $1, $5);
+                            $$ = Flat(result, new VarDecl(id, $2, $1, $5));
                          }
               | TypeDecl T_Identifier T_LeftBracket T_IntConstant T_RightBracket 
                          { 
                             Identifier *id = new Identifier(@2, (const char *)$2);
-                            $$ = new VarDecl(id, new ArrayType(@1, $1, $4));
+                            $$ = Flat(result, new VarDecl(id, new ArrayType(@1, $1, $4)));
                          }
               | TypeQualify TypeDecl T_Identifier T_LeftBracket T_IntConstant T_RightBracket 
                          { 
                             Identifier *id = new Identifier(@3, $3);
-                            $$ = new VarDecl(id, new ArrayType(@2, $2, $5), $1);
+                            $$ = Flat(result, new VarDecl(id, new ArrayType(@2, $2, $5), $1));
                          }
 
               ;
@@ -248,8 +279,8 @@ TypeDecl       : T_Int                   { $$ = Type::intType;    }
                | T_Mat4                  { $$ = Type::mat4Type;   }
                ;
 
-CompoundStatement : T_LeftBrace T_RightBrace               { $$ = new StmtBlock(new List<VarDecl*>, new List<Stmt *>); }
-                  | T_LeftBrace StatementList T_RightBrace { $$ = new StmtBlock(new List<VarDecl*>, $2); }
+CompoundStatement : T_LeftBrace T_RightBrace               { $$ = Flat(result, new StmtBlock(new List<VarDecl*>, new List<Stmt *>)); }
+                  | T_LeftBrace StatementList T_RightBrace { $$ = Flat(result, new StmtBlock(new List<VarDecl*>, $2)); }
                   ;
 
 StatementList : Statement                     { ($$ = new List<Stmt*>)->Append($1); }
@@ -260,10 +291,10 @@ Statement      : CompoundStatement         { $$ = $1; }
                | SingleStatement           { $$ = $1; }
                ;
 
-SingleStatement   : T_Semicolon      { $$ = new EmptyExpr();  }
+SingleStatement   : T_Semicolon      { $$ = Flat(result, new EmptyExpr());  }
                   | SingleDecl T_Semicolon 
                                      {
-                                       $$ = new DeclStmt($1);
+                                       $$ = Flat(result, new DeclStmt($1));
                                      }
                   | Expression T_Semicolon { $$ = $1; }
                   | SelectionStmt    { $$ = $1; }
@@ -276,44 +307,44 @@ SingleStatement   : T_Semicolon      { $$ = new EmptyExpr();  }
 
 SelectionStmt     : T_If T_LeftParen Expression T_RightParen Statement T_Else Statement
                                      {
-                                        $$ = new IfStmt($3, $5, $7);
+                                        $$ = Flat(result, new IfStmt($3, $5, $7));
                                      }
                    | T_If T_LeftParen Expression T_RightParen Statement %prec LOWER_THAN_ELSE
                                      {
-                                        $$ = new IfStmt($3, $5, NULL);
+                                        $$ = Flat(result, new IfStmt($3, $5, NULL));
                                      }
                    ;
 
 SwitchStmt         : T_Switch T_LeftParen Expression T_RightParen T_LeftBrace StatementList T_RightBrace
                                      {
-                                        $$ = new SwitchStmt($3, $6, NULL);
+                                        $$ = Flat(result, new SwitchStmt($3, $6, NULL));
                                      }
                    ;
-CaseStmt           : T_Case Expression T_Colon Statement  { $$ = new Case($2, $4); }
-                   | T_Default T_Colon Statement          { $$ = new Default($3); }
+CaseStmt           : T_Case Expression T_Colon Statement  { $$ = Flat(result, new Case($2, $4)); }
+                   | T_Default T_Colon Statement          { $$ = Flat(result, new Default($3)); }
                    ;
 
-JumpStmt           : T_Break   T_Semicolon    { $$ = new BreakStmt(yylloc); }
-                   | T_Continue T_Semicolon   { $$ = new ContinueStmt(yylloc); }
-                   | T_Return T_Semicolon     { $$ = new ReturnStmt(yylloc); }
-                   | T_Return Expression T_Semicolon { $$ = new ReturnStmt(yyloc, $2); }
+JumpStmt           : T_Break   T_Semicolon    { $$ = Flat(result, new BreakStmt(yylloc)); }
+                   | T_Continue T_Semicolon   { $$ = Flat(result, new ContinueStmt(yylloc)); }
+                   | T_Return T_Semicolon     { $$ = Flat(result, new ReturnStmt(yylloc)); }
+                   | T_Return Expression T_Semicolon { $$ = Flat(result, new ReturnStmt(yyloc, $2)); }
                    ; 
 
-WhileStmt          : T_While T_LeftParen Expression T_RightParen Statement { $$ = new WhileStmt($3, $5); }
+WhileStmt          : T_While T_LeftParen Expression T_RightParen Statement { $$ = Flat(result, new WhileStmt($3, $5)); }
                    ;
 
 ForStmt            : T_For T_LeftParen Expression T_Semicolon Expression T_Semicolon Expression T_RightParen Statement
                                  {
-                                    $$ = new ForStmt($3, $5, $7, $9);
+                                    $$ = Flat(result, new ForStmt($3, $5, $7, $9));
                                  }
                    ;
 
 PrimaryExpr        : T_Identifier    { Identifier *id = new Identifier(yylloc, (const char*)$1);
-                                       $$ = new VarExpr(yyloc, id);
+                                       $$ = Flat(result, new VarExpr(yyloc, id));
                                      }
-                   | T_IntConstant   { $$ = new IntConstant(yylloc, $1); }
-                   | T_FloatConstant { $$ = new FloatConstant(yylloc, $1); } 
-                   | T_BoolConstant  { $$ = new BoolConstant(yylloc, $1); }
+                   | T_IntConstant   { $$ = Flat(result, new IntConstant(yylloc, $1)); }
+                   | T_FloatConstant { $$ = Flat(result, new FloatConstant(yylloc, $1)); } 
+                   | T_BoolConstant  { $$ = Flat(result, new BoolConstant(yylloc, $1)); }
                    | T_LeftParen Expression T_RightParen { $$ = $2;}
                    ;
 
@@ -321,11 +352,11 @@ FunctionCallExpr     : FunctionCallHeaderWithParameters T_RightParen { $$ = $1;
                      | FunctionCallHeaderNoParameters T_RightParen   { $$ = $1; }
                      ;
 
-FunctionCallHeaderNoParameters     : FunctionIdentifier T_LeftParen T_Void { $$ = new Call(@1, NULL, $1, new List<Expr*>); }
-                                   | FunctionIdentifier T_LeftParen        { $$ = new Call(@1, NULL, $1, new List<Expr*>); }
+FunctionCallHeaderNoParameters     : FunctionIdentifier T_LeftParen T_Void { $$ = Flat(result, new Call(@1, NULL, $1, new List<Expr*>)); }
+                                   | FunctionIdentifier T_LeftParen        { $$ = Flat(result, new Call(@1, NULL, $1, new List<Expr*>)); }
                                    ;
 
-FunctionCallHeaderWithParameters   : FunctionIdentifier T_LeftParen ArgumentList { $$ = new Call(@1, NULL, $1, $3);}
+FunctionCallHeaderWithParameters   : FunctionIdentifier T_LeftParen ArgumentList { $$ = Flat(result, new Call(@1, NULL, $1, $3));}
                                    ;
 
 ArgumentList : Expression                       { ($$ = new List<Expr*>)->Append($1);}
@@ -336,24 +367,24 @@ FunctionIdentifier  : T_Identifier        { $$ = new Identifier(@1, $1); }
                     ;
 
 PostfixExpr        : PrimaryExpr     { $$ = $1; }
-                   | PostfixExpr T_LeftBracket Expression T_RightBracket { $$ = new ArrayAccess(@1, $1, $3); }
+                   | PostfixExpr T_LeftBracket Expression T_RightBracket { $$ = Flat(result, new ArrayAccess(@1, $1, $3)); }
                    | FunctionCallExpr
                                        {
                                        }
                    | PostfixExpr T_Inc 
                                        {
-                                          Operator *op = new Operator(yylloc, (const char *)$2);
-                                          $$ = new PostfixExpr($1, op);
+                                          Operator *op = new Operator(yylloc, $2);
+                                          $$ = Flat(result, new PostfixExpr($1, op));
                                        }
                    | PostfixExpr T_Dec 
                                        {
-                                          Operator *op = new Operator(yylloc, (const char *)$2);
-                                          $$ = new PostfixExpr($1, op);
+                                          Operator *op = new Operator(yylloc, $2);
+                                          $$ = Flat(result, new PostfixExpr($1, op));
                                        }
                    | PostfixExpr T_Dot T_FieldSelection
                                        {
                                           Identifier *id = new Identifier(yylloc, (const char *)$3);
-                                          $$ = new FieldAccess($1, id);
+                                          $$ = Flat(result, new FieldAccess($1, id));
                                        }
                    ;
 
@@ -361,22 +392,22 @@ UnaryExpr          : PostfixExpr     { $$ = $1; }
                    | T_Inc UnaryExpr
                            {
                              Operator *op = new Operator(yylloc, $1);
-                             $$ = new ArithmeticExpr(op, $2);
+                             $$ = Flat(result, new ArithmeticExpr(op, $2));
                            }
                    | T_Dec UnaryExpr
                            {
                              Operator *op = new Operator(yylloc, $1);
-                             $$ = new ArithmeticExpr(op, $2);
+                             $$ = Flat(result, new ArithmeticExpr(op, $2));
                            }
                    | T_Plus UnaryExpr
                            {
                              Operator *op = new Operator(yylloc, $1);
-                             $$ = new ArithmeticExpr(op, $2);
+                             $$ = Flat(result, new ArithmeticExpr(op, $2));
                            }
                    | T_Dash UnaryExpr
                            {
                              Operator *op = new Operator(yylloc, $1);
-                             $$ = new ArithmeticExpr(op, $2);
+                             $$ = Flat(result, new ArithmeticExpr(op, $2));
                            }
                    ;
 
@@ -384,12 +415,12 @@ MultiExpr          : UnaryExpr       { $$ = $1; }
                    | MultiExpr T_Star UnaryExpr
                            {
                              Operator *op = new Operator(yylloc, $2);
-                             $$ = new ArithmeticExpr($1, op, $3);
+                             $$ = Flat(result, new ArithmeticExpr($1, op, $3));
                            }
                    | MultiExpr T_Slash UnaryExpr
                            {
                              Operator *op = new Operator(yylloc, $2);
-                             $$ = new ArithmeticExpr($1, op, $3);
+                             $$ = Flat(result, new ArithmeticExpr($1, op, $3));
                            }
                    ;
 
@@ -397,12 +428,12 @@ AdditionExpr       : MultiExpr       { $$ = $1; }
                    | AdditionExpr T_Plus MultiExpr
                            {
                              Operator *op = new Operator(yylloc, $2);
-                             $$ = new ArithmeticExpr($1, op, $3);
+                             $$ = Flat(result, new ArithmeticExpr($1, op, $3));
                            }
                    | AdditionExpr T_Dash MultiExpr
                            {
                              Operator *op = new Operator(yylloc, $2);
-                             $$ = new ArithmeticExpr($1, op, $3);
+                             $$ = Flat(result, new ArithmeticExpr($1, op, $3));
                            }
                    ;
 
@@ -410,22 +441,22 @@ RelationExpr       : AdditionExpr       { $$ = $1; }
                    | RelationExpr T_LeftAngle AdditionExpr
                            {
                              Operator *op = new Operator(yylloc, $2);
-                             $$ = new RelationalExpr($1, op, $3);
+                             $$ = Flat(result, new RelationalExpr($1, op, $3));
                            }
                    | RelationExpr T_RightAngle AdditionExpr
                            {
                              Operator *op = new Operator(yylloc, $2);
-                             $$ = new RelationalExpr($1, op, $3);
+                             $$ = Flat(result, new RelationalExpr($1, op, $3));
                            }
                    | RelationExpr T_GreaterEqual AdditionExpr
                            {
                              Operator *op = new Operator(yylloc, $2);
-                             $$ = new RelationalExpr($1, op, $3);
+                             $$ = Flat(result, new RelationalExpr($1, op, $3));
                            }
                    | RelationExpr T_LessEqual AdditionExpr
                            {
                              Operator *op = new Operator(yylloc, $2);
-                             $$ = new RelationalExpr($1, op, $3);
+                             $$ = Flat(result, new RelationalExpr($1, op, $3));
                            }
                    ;
 
@@ -433,12 +464,12 @@ EqualityExpr       : RelationExpr       { $$ = $1; }
                    | EqualityExpr T_EQ RelationExpr 
                            {
                              Operator *op = new Operator(yylloc, $2);
-                             $$ = new ArithmeticExpr($1, op, $3);
+                             $$ = Flat(result, new ArithmeticExpr($1, op, $3));
                            }
                    | EqualityExpr T_NE RelationExpr 
                            {
                              Operator *op = new Operator(yylloc, $2);
-                             $$ = new ArithmeticExpr($1, op, $3);
+                             $$ = Flat(result, new ArithmeticExpr($1, op, $3));
                            }
                    ;
 
@@ -446,7 +477,7 @@ LogicAndExpr       : EqualityExpr       { $$ = $1; }
                    | LogicAndExpr T_And EqualityExpr
                            {
                              Operator *op = new Operator(yylloc, $2);
-                             $$ = new ArithmeticExpr($1, op, $3);
+                             $$ = Flat(result, new ArithmeticExpr($1, op, $3));
                            }
                    ;
 
@@ -454,26 +485,26 @@ LogicOrExpr        : LogicAndExpr       { $$ = $1; }
                    | LogicOrExpr T_Or LogicAndExpr
                            {
                              Operator *op = new Operator(yylloc, $2);
-                             $$ = new ArithmeticExpr($1, op, $3);
+                             $$ = Flat(result, new ArithmeticExpr($1, op, $3));
                            }
                    ;
 
 Expression         : LogicOrExpr       { $$ = $1; }
                    | LogicOrExpr T_Question LogicOrExpr T_Colon LogicOrExpr
                            {
-                             $$ = new ConditionalExpr($1, $3, $5);
+                             $$ = Flat(result, new ConditionalExpr($1, $3, $5));
                            }
                    | UnaryExpr AssignOp Expression
                            {
-                             $$ = new AssignExpr($1, $2, $3);
+                             $$ = Flat(result, new AssignExpr($1, $2, $3));
                            }
                    ;
 
 AssignOp           : T_Equal         { $$ = new Operator(yylloc, $1);   }
-                   | T_AddAssign     { $$ = new Operator(yylloc, "+=");  }
-                   | T_SubAssign     { $$ = new Operator(yylloc, "-=");  }
-                   | T_MulAssign     { $$ = new Operator(yylloc, "*=");  }
-                   | T_DivAssign     { $$ = new Operator(yylloc, "/=");  }
+                   | T_AddAssign     { $$ = new Operator(yylloc, $1);   }
+                   | T_SubAssign     { $$ = new Operator(yylloc, $1);   }
+                   | T_MulAssign     { $$ = new Operator(yylloc, $1);   }
+                   | T_DivAssign     { $$ = new Operator(yylloc, $1);   }
                    ;
 
 %%
@@ -502,3 +533,66 @@ void InitParser()
    PrintDebug("parser", "Initializing parser");
    yydebug = false;
 }
+
+
+/* Function: Flat
+ * --------------
+ * Called by each action that makes a node, once the node is complete, to
+ * lay down its row in the flat tree (see ast_flat.h). Its children were
+ * laid down by the actions that made them, except for the identifiers,
+ * operators and built-in types made along with it, which get theirs now.
+ * A function's row waits for its body, if it has one.
+ */
+template<class T> static T *Flat(ParseResult *result, T *node)
+{
+   result->flat.Add(node);
+   return node;
+}
+
+/* Function: DeclParsed
+ * --------------------
+ * Called as each top-level declaration is added to the DeclList. If the
+ * caller asked for it, the declaration is run through the passes right
+ * away, as the whole program would have been; as with a whole program,
+ * nothing is checked once a lexical or syntax error has been reported.
+ */
+static void DeclParsed(ParseResult *result, Decl *decl)
+{
+   if (!result->passes || ReportError::NumErrors() > result->checkErrors)
+      return;
+   int before = ReportError::NumErrors();
+   result->passes->Run(&result->tree, decl->GetRow());
+   result->checkErrors += ReportError::NumErrors() - before;
+}
+
+/* Function: ParseStream
+ * ---------------------
+ * Parses input that is still arriving, for a scanner set up by
+ * InitStreamScanner(). Tokens are pushed into the parser as soon as a
+ * complete line containing them has been read, and more input is waited
+ * for only when the scanner has nothing left, so parsing and checking
+ * the front of the input overlaps with reading the rest. Each top-level
+ * declaration is run through the given passes as it is parsed.
+ */
+void ParseStream(ScanContext *scanner, ParseResult *result, PassManager *passes)
+{
+   result->passes = passes;
+   passes->Begin();
+   yypstate *ps = yypstate_new();
+   if (!ps) Failure("Unable to create parser");
+
+   YYSTYPE lval;
+   YYLTYPE lloc = {};
+   int status = YYPUSH_MORE;
+   while (status == YYPUSH_MORE) {
+      if (ScannerNeedsInput(scanner)) {
+         ReadMoreInput(scanner);
+         continue;
+      }
+      int token = yylex(&lval, &lloc, scanner);
+      if (token == 0 && ScannerNeedsInput(scanner))
+         continue; // only whitespace or comments before the cut
+      status = yypush_parse(ps, token, &lval, &lloc, scanner, result);
+   }
+   yypstate_delete(ps);
+}
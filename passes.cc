@@ -0,0 +1,75 @@
+/* File: passes.cc
+ * ---------------
+ * Running the passes in order and timing them.
+ */
+
+#include <string.h>
+#include <chrono>
+#include "passes.h"
+
+PassManager::~PassManager() {
+    for (size_t i = 0; i < passes.size(); i++)
+        delete passes[i].pass;
+}
+
+void PassManager::Add(Pass *pass) {
+    Entry e = { pass, true, 0, 0, {0, 0} };
+    passes.push_back(e);
+}
+
+bool PassManager::SetEnabled(const char *name, bool enabled) {
+    for (size_t i = 0; i < passes.size(); i++) {
+        if (strcmp(passes[i].pass->GetName(), name) == 0) {
+            passes[i].enabled = enabled;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PassManager::Begin() {
+    for (size_t i = 0; i < passes.size(); i++) {
+        Entry &e = passes[i];
+        e.pass->Begin();
+        e.runs = 0;
+        e.seconds = 0;
+        e.allocs.count = e.allocs.bytes = 0;
+    }
+}
+
+void PassManager::Run(FlatTree *tree, FlatTree::Index root) {
+    typedef std::chrono::steady_clock Clock;
+    for (size_t i = 0; i < passes.size(); i++) {
+        Entry &e = passes[i];
+        if (!e.enabled) continue;
+        AllocStats before = ::GetAllocStats();
+        Clock::time_point start = Clock::now();
+        e.pass->Run(tree, root);
+        e.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+        e.allocs += ::GetAllocStats() - before;
+        e.runs++;
+    }
+}
+
+AllocStats PassManager::GetAllocStats() const {
+    AllocStats total = { 0, 0 };
+    for (size_t i = 0; i < passes.size(); i++)
+        total += passes[i].allocs;
+    return total;
+}
+
+void PassManager::PrintTimings(FILE *out) {
+    double total = 0;
+    for (size_t i = 0; i < passes.size(); i++)
+        total += passes[i].seconds;
+    fprintf(out, "%-12s %6s %12s %7s\n", "pass", "runs", "time (ms)", "share");
+    for (size_t i = 0; i < passes.size(); i++) {
+        const Entry &e = passes[i];
+        if (!e.enabled) {
+            fprintf(out, "%-12s %6s\n", e.pass->GetName(), "off");
+            continue;
+        }
+        fprintf(out, "%-12s %6d %12.3f %6.1f%%\n", e.pass->GetName(), e.runs,
+                e.seconds * 1000, total > 0 ? 100 * e.seconds / total : 0.0);
+    }
+}
@@ -0,0 +1,81 @@
+/* File: passes.h
+ * --------------
+ * Semantic analysis is a sequence of passes over the flat form of the
+ * tree (see ast_flat.h). Each pass is an object that keeps whatever
+ * state its analysis needs between nodes (the scopes, the loops it is
+ * inside of, and so on), which lasts for one program. A PassManager
+ * runs its passes in order over either a whole Program or, with
+ * --stream, one top-level declaration at a time, and keeps track of how
+ * long each one takes and how much it allocates from the heap;
+ * -d timePasses and -d allocstats print those at the end.
+ *
+ * A pass can be switched off by name, on the command line with
+ * --disable-pass=<name>, leaving the others to run; note that the checks
+ * rely on the names having been resolved by the "bind" pass.
+ */
+
+#ifndef _H_passes
+#define _H_passes
+
+#include <stdio.h>
+#include <vector>
+#include "allocstats.h"
+#include "ast_flat.h"
+
+class Pass
+{
+  public:
+    virtual ~Pass() {}
+    virtual const char *GetName() = 0;
+
+          // Called before a new program is run through the pass
+    virtual void Begin() {}
+
+          // Runs the pass over a Program or a single top-level Decl of
+          // one, given the row of either in tree
+    virtual void Run(FlatTree *tree, FlatTree::Index root) = 0;
+};
+
+class PassManager
+{
+    struct Entry {
+      Pass *pass;
+      bool enabled;
+      int runs;
+      double seconds;
+      AllocStats allocs;
+    };
+    std::vector<Entry> passes;
+
+  public:
+    PassManager() {}
+    ~PassManager();
+
+          // Adds a pass to run after those already added, taking ownership
+    void Add(Pass *pass);
+
+          // Switches the named pass on or off; false if there is none
+    bool SetEnabled(const char *name, bool enabled);
+
+          // Readies the passes for a new program, and starts counting
+          // their runs, time and allocations afresh
+    void Begin();
+    void Run(FlatTree *tree, FlatTree::Index root);
+
+    int NumPasses() const { return passes.size(); }
+    Pass *GetPass(int i) const { return passes[i].pass; }
+
+          // Heap allocations made by the i'th pass since Begin(), and by
+          // them all
+    AllocStats GetAllocStats(int i) const { return passes[i].allocs; }
+    AllocStats GetAllocStats() const;
+
+          // Time spent in each pass since Begin(), one line per pass
+    void PrintTimings(FILE *out);
+
+  private:
+    PassManager(const PassManager &);
+    PassManager &operator=(const PassManager &);
+};
+
+#endif
@@ -0,0 +1,58 @@
+/* File: pooltest.cc
+ * -----------------
+ * A check of the order ThreadPool starts tasks in, built with "make
+ * pooltest". It submits a run of slow tasks, each sleeping a moment, and
+ * records the order they start in. Every worker takes the oldest of the
+ * tasks it was dealt first, so each task should start within about one
+ * round of the workers of where it was submitted; a pool that took the
+ * newest first would start the last ones submitted before the first.
+ *
+ * Usage: pooltest [<threads> [<tasks>]]
+ * Prints the start order and exits with 1 if it is out of order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "threadpool.h"
+
+static const int SleepMs = 10;      // how long each task takes
+
+int main(int argc, char *argv[])
+{
+    int threads = (argc > 1 ? atoi(argv[1]) : 4);
+    int tasks = (argc > 2 ? atoi(argv[2]) : 16 * threads);
+    std::vector<int> started;
+    std::mutex lock;
+
+    {
+        ThreadPool pool(threads);
+        threads = pool.NumThreads();
+        for (int i = 0; i < tasks; i++) {
+            pool.Submit([&, i] {
+                {
+                    std::lock_guard<std::mutex> hold(lock);
+                    started.push_back(i);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(SleepMs));
+            });
+        }
+        pool.Wait();
+    }
+
+    // a task may start a round early or late, when a worker steals or
+    // runs behind, but no further
+    int slack = 2 * threads;
+    int misplaced = 0;
+    for (int pos = 0; pos < tasks; pos++) {
+        printf("%d%c", started[pos], (pos % 16 == 15 || pos == tasks-1) ? '\n' : ' ');
+        if (abs(started[pos] - pos) > slack)
+            misplaced++;
+    }
+    printf("%d of %d tasks on %d threads started more than %d places "
+           "from where they were submitted\n", misplaced, tasks, threads, slack);
+    return (misplaced == 0? 0 : 1);
+}
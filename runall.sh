@@ -11,7 +11,6 @@ else
 	done
 fi
 
-for file in $LIST; do
-        echo $file
-	./glc < $file 
-done
+# one process for the lot; the output of each file still comes out
+# under its name, in the order listed
+./glc --batch $LIST
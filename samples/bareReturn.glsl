@@ -0,0 +1,9 @@
+int f(int x){
+  if (x > 0)
+    return;
+  return x;
+}
+
+void main(){
+  f(1);
+}
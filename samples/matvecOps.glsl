@@ -0,0 +1,14 @@
+void main(){
+  vec3 v3;
+  vec4 v4;
+  mat2 m2;
+  mat4 m4;
+  vec2 v2;
+  float f;
+
+  v4 = m4 * v4;
+  v3 = v3 * f;
+  v4 *= m4;
+  m4 *= v4;
+  m2 = m2 + v2;
+}
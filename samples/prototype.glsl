@@ -0,0 +1,6 @@
+float g(float y);
+
+void main(){
+  float z;
+  z = g(2.0);
+}
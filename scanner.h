@@ -3,21 +3,55 @@
  * You should not need to modify this file. It declare a few constants,
  * types, variables,and functions that are used and/or exported by
  * the lex-generated scanner.
+ *
+ * The scanner is reentrant: everything it needs between calls to yylex
+ * lives in a ScanContext, so any number of inputs can be scanned at once
+ * on different threads, each with its own context.
  */
 
 #ifndef _H_scanner
 #define _H_scanner
 
 #include <stdio.h>
+#include <string>
+#include "location.h"
+#include "source.h"
+#include "fastscan.h"
 
 #define MaxIdentLen 31    // Maximum length for identifiers
 
-extern char *yytext;      // Text of lexeme just scanned
+/* Class: ScanContext
+ * ------------------
+ * The state for scanning one input: its source text, whichever engine is
+ * reading it, and the flex engine's line and column counters. It is
+ * handed to yyparse, which passes it back on each call to yylex.
+ */
+class ScanContext
+{
+  public:
+    SourceBuffer source;        // entire input, mapped file or stdin
+    FastScanner fastScanner;    // used instead of flex for --scanner=fast
+    bool useFastScanner;
+    void *flexScanner;          // yyscan_t of the reentrant flex scanner
+    int curLineNum, curColNum;  // position of the flex scanner
+    std::string heldLine;       // see GetLineNumbered()
+    int streamFd;               // descriptor being streamed, or -1
+    bool closeStream;           // whether we opened streamFd ourselves
+
+    ScanContext();
+    ~ScanContext();
+};
+
+union YYSTYPE;
 
+int yylex(union YYSTYPE *lvalp, yyltype *llocp, ScanContext *ctx); // Defined in scanner.l
 
-int yylex();              // Defined in the generated lex.yy.c file
+void InitScanner(ScanContext *ctx, const char *path); // Defined in scanner.l user subroutines
+void InitScanner(ScanContext *ctx, const char *text, size_t len, bool useFastScanner); // ditto
+void InitStreamScanner(ScanContext *ctx, const char *path); // ditto
+bool ScannerNeedsInput(ScanContext *ctx); // ditto
+void ReadMoreInput(ScanContext *ctx); // ditto
+const char *GetLineNumbered(int n, int *len); // ditto
+yyltype ExpandRange(SourceRange range); // ditto
 
-void InitScanner();                 // Defined in scanner.l user subroutines
-const char *GetLineNumbered(int n); // ditto
- 
 #endif
@@ -0,0 +1,595 @@
+/* File: semantic.cc
+ * -----------------
+ * The name binding and checking passes.
+ */
+
+#include <string.h>
+#include <vector>
+#include "semantic.h"
+#include "errors.h"
+#include "compilation.h"
+#include "threadpool.h"
+
+void AddSemanticPasses(PassManager *passes, ThreadPool *pool) {
+    passes->Add(new BindPass);
+    passes->Add(new CheckPass(pool));
+}
+
+
+/************************************************************
+ * BindPass
+ */
+
+/* Every child is visited in order, the same for every kind of node that
+ * doesn't open a scope or bind a name.
+ */
+void BindPass::VisitNode(Row n) {
+	for( Row child : tree->Children(n) )
+		if( child != FlatTree::None )
+			Visit(child);
+}
+
+void BindPass::VisitVarDecl(Row var) {
+	// the initializer can't see the variable it initializes
+	VisitNode(var);
+	Symbol declaration(tree->value[tree->DeclId(var)].name, var, E_VarDecl);
+	tree->decl[var] = symtable.insert(declaration);
+}
+
+void BindPass::VisitFnDecl(Row fn) {
+	Symbol declaration(tree->value[tree->DeclId(fn)].name, fn, E_FunctionDecl);
+	tree->decl[fn] = symtable.insert(declaration);
+	Row body = tree->LastChild(fn);
+	if( body == FlatTree::None )
+		return;
+
+	symtable.push();
+
+	// list of arguments
+	for( Row var : tree->Children(fn, 2, 1) )
+		Visit(var);
+
+	// the body shares the scope of the arguments
+	VisitNode(body);
+
+	symtable.pop();
+}
+
+void BindPass::VisitStmtBlock(Row block) {
+	/** insert new scope **/
+	symtable.push();
+
+	VisitNode(block);
+
+	/** remove current scope **/
+	symtable.pop();
+}
+
+void BindPass::VisitVarExpr(Row expr) {
+	Symbol *found = symtable.find(tree->value[tree->Child(expr, 0)].name);
+	tree->decl[expr] = (found != NULL ? found->decl : FlatTree::None);
+}
+
+void BindPass::VisitCall(Row call) {
+	VisitNode(call);
+	Symbol *found = symtable.find(tree->value[tree->Child(call, 1)].name);
+	tree->decl[call] = (found != NULL ? found->decl : FlatTree::None);
+}
+
+
+/************************************************************
+ * CheckPass
+ */
+void CheckPass::Begin() {
+    returnType = NULL;
+    foundReturn = false;
+    loops = 0;
+    switchStmt = 0;
+}
+
+void CheckPass::VisitProgram(Row program) {
+    /* pp3: here is where the semantic analyzer is kicked off.
+     *      The general idea is perform a tree traversal of the
+     *      entire program, examining all constructs for compliance
+     *      with the semantic rules.
+     */
+    if ( pool != NULL && tree->NumChildren(program) > 1 ) {
+        CheckInParallel(program);
+        return;
+    }
+    for ( Row d : tree->Children(program) )
+        Visit(d);
+
+    // test to see if symtables are working (comment out before turning in)
+    //program->testSymTables();
+}
+
+/* Each declaration is checked by a checker of its own on one of the
+ * pool's threads, working for this thread's compilation so that its
+ * errors quote from the input and are counted against it. The output of
+ * each is handed back here to be written out in order. The checkers
+ * share the tree, but each only writes the rows of its own declaration.
+ */
+void CheckPass::CheckInParallel(Row program) {
+	FlatTree::Run decls = tree->Children(program);
+	int n = decls.end() - decls.begin();
+	std::vector<OutputCapture *> outputs(n);
+	CompilationContext *context = CompilationContext::Current();
+	FlatTree *t = tree;
+
+	for (int i = 0; i < n; i++) {
+		Row decl = decls.begin()[i];
+		pool->Submit([=, &outputs] {
+			CompilationScope useContext(context);
+			OutputCapture *capture = new OutputCapture;
+			CheckPass checker;
+			checker.Run(t, decl);
+			capture->Stop();
+			outputs[i] = capture;
+		});
+	}
+	pool->Wait();
+
+	for (int i = 0; i < n; i++) {
+		outputs[i]->Replay();
+		delete outputs[i];
+	}
+}
+
+void CheckPass::VisitVarDecl(Row var) {
+
+	// push this error upstream so we have logic for cascading errors
+	fprintf(OutputFile(), "VarDecl Check!\n");
+
+	bool typeFlag = false;
+
+	/**** Check for type errors ***************/
+	Row init = tree->Child(var, 3);
+	if( init != FlatTree::None ) {
+
+		Type * vtype = GetType(init, &typeFlag);
+		Type * declared = tree->value[tree->Child(var, 1)].type;
+
+		if( !declared->IsEquivalentTo(vtype) ) {
+			if(typeFlag == false)
+				ReportError::InvalidInitialization(tree, tree->DeclId(var), declared, vtype);
+			typeFlag = true;
+		}
+	}
+
+	/**** check for redeclaration error *******/
+	if( tree->decl[var] != FlatTree::None && typeFlag == false ) {
+		ReportError::DeclConflict(tree, var, tree->decl[var]);
+		typeFlag = true;
+	}
+
+}
+
+void CheckPass::VisitFnDecl(Row fn) {
+  fprintf(OutputFile(), "FuncDecl Check!\n");
+
+	bool typeFlag = false;
+
+	/**** Check for redeclaration errors *****/
+  // function name
+	if( tree->decl[fn] != FlatTree::None ) {
+		ReportError::DeclConflict(tree, fn, tree->decl[fn]);
+		typeFlag = true;
+	}
+
+	/***** Check for type errors ********************************/
+  	/**** Check return types	****/
+	// functions don't nest, so there is only ever the one
+	returnType = tree->value[tree->Child(fn, 0)].type;
+	// true if it's void, false until a return is found if it isn't
+	foundReturn = returnType->IsEquivalentTo(Type::voidType);
+
+  CheckBlock(fn);
+
+  	/*** Check if return statement is found or not ****/
+	// a prototype has no body to return from
+	if( foundReturn == false && tree->LastChild(fn) != FlatTree::None ) {
+		ReportError::ReturnMissing(tree, fn);
+	}
+	returnType = NULL;
+}
+
+void CheckPass::VisitStmtBlock(Row block) {
+	fprintf(OutputFile(), "StmtBlock Check!\n");
+
+	for(Row stmt : tree->Children(block))
+		Visit(stmt);
+}
+
+void CheckPass::CheckBlock(Row fn) {
+  bool typeFlag = false;
+
+  // list of arguments
+  for( Row var : tree->Children(fn, 2, 1) ) {
+    Row conflict = tree->decl[var];
+    if( conflict != FlatTree::None && typeFlag == false ) {
+      ReportError::DeclConflict(tree, var, conflict);
+      typeFlag = true;
+    }
+  }
+
+  /** go through the list of stmts declarations **/
+	Row body = tree->LastChild(fn);
+	if( body == FlatTree::None )
+		return;
+	for(Row stmt : tree->Children(body))
+		Visit(stmt);
+}
+
+void CheckPass::VisitDeclStmt(Row stmt) {
+	Visit(tree->Child(stmt, 0));
+}
+
+void CheckPass::VisitReturnStmt(Row stmt) {
+	fputs("ReturnStmt Check!", OutputFile());
+	fflush(OutputFile());
+  bool typeError = false;
+  Row expr = tree->Child(stmt, 0);
+
+	// every return is held to the function's type, a bare one as void
+	Type* rType = (expr != FlatTree::None ? GetType(expr, &typeError) : Type::voidType);
+	if( returnType != NULL && !returnType->IsEquivalentTo(rType) ) {
+		ReportError::ReturnMismatch(tree, stmt, rType, returnType);
+		typeError = true;
+	}
+	foundReturn = true; // found return statement
+}
+
+void CheckPass::VisitIfStmt(Row stmt) {
+
+	/** check the type for test **/
+	bool typeError = false;
+	Row test = tree->Child(stmt, 0);
+	Type* ifType = GetType(test, &typeError);
+	if(typeError == false) {
+		if( !ifType->IsEquivalentTo(Type::boolType) ) {
+			ReportError::TestNotBoolean(tree, test);
+			typeError = true;
+		}
+	}
+	/** check the type for stmt body **/
+	Row body = tree->Child(stmt, 1), elseBody = tree->Child(stmt, 2);
+	if(body != FlatTree::None) Visit(body);
+	if(elseBody != FlatTree::None) Visit(elseBody);
+}
+
+void CheckPass::VisitSwitchStmt(Row stmt) {
+
+	fputs("SwitchStmt Check!\n", OutputFile());
+	fflush(OutputFile());
+  switchStmt++;
+
+	bool typeFlag = false;
+	//switch test
+	Row expr = tree->Child(stmt, 0);
+	if(expr != FlatTree::None) GetType(expr, &typeFlag);
+	//cases
+	for(Row switchCase : tree->Children(stmt, 1, 1))
+		Visit(switchCase);
+	// default
+	Row def = tree->LastChild(stmt);
+	if(def != FlatTree::None) Visit(def);
+  switchStmt--;
+
+}
+
+void CheckPass::VisitCase(Row label) {
+	fputs("Case Check!\n", OutputFile());
+	fflush(OutputFile());
+	VisitDefault(label);
+}
+
+void CheckPass::VisitDefault(Row label) {
+	bool typeFlag = false;
+	Row expr = tree->Child(label, 0), stmt = tree->Child(label, 1);
+	if( expr != FlatTree::None ) GetType(expr, &typeFlag);
+	if( stmt != FlatTree::None ) Visit(stmt);
+}
+
+
+void CheckPass::VisitWhileStmt(Row stmt) {
+  loops++;
+	/** check the test expr **/
+	bool typeError = false;
+	Row test = tree->Child(stmt, 0);
+	Type* whileType = GetType(test, &typeError);
+	if(typeError == false){
+		if( !whileType->IsEquivalentTo(Type::boolType) ){
+			ReportError::TestNotBoolean(tree, test);
+			typeError = true;
+		}
+	}
+
+	/** check on stmts in the body **/
+	Row body = tree->Child(stmt, 1);
+	if(body != FlatTree::None) Visit(body);
+
+  loops--;
+}
+
+void CheckPass::VisitForStmt(Row stmt) {
+  loops++;
+
+	Row init = tree->Child(stmt, 0), test = tree->Child(stmt, 1);
+	Row step = tree->Child(stmt, 2), body = tree->Child(stmt, 3);
+	if( init != FlatTree::None ) Visit(init);
+	bool typeError = false;
+	Type* testType = GetType(test, &typeError);
+	if(typeError == false) {
+		if( !testType->IsEquivalentTo(Type::boolType) ){
+			ReportError::TestNotBoolean(tree, test);
+			typeError = true;
+		}
+	}
+	if( step != FlatTree::None ) Visit(step);
+	if( body != FlatTree::None ) Visit(body);
+  loops--;
+}
+
+void CheckPass::VisitBreakStmt(Row stmt) {
+	/* break is only allowed inside a loop */
+
+  // report error if not in loop and switch
+  if( loops <= 0   && switchStmt <= 0 ) {
+    ReportError::BreakOutsideLoop(tree, stmt);
+  }
+}
+
+void CheckPass::VisitContinueStmt(Row stmt) {
+  // report error if not in loop
+  if( loops <= 0 ) {
+    ReportError::ContinueOutsideLoop(tree, stmt);
+  }
+}
+
+void CheckPass::VisitExpr(Row expr) {
+	bool flag = false;
+	GetType(expr, &flag);
+}
+
+
+/************************************************************
+ * Types of expressions
+ */
+
+/* The type is computed once and remembered, so an expression that is
+ * asked again (or whose parent is) costs nothing and reports nothing
+ * new. If the caller's flag was already set on the first call, errors in
+ * the subtree were suppressed and can't be told apart, so the subtree
+ * counts as erroneous.
+ */
+Type *CheckPass::GetType(Row expr, bool *typeFlag) {
+	if( tree->type[expr] == NULL ) {
+		tree->type[expr] = ComputeType(expr, typeFlag);
+		tree->typeFailed[expr] = *typeFlag;
+	} else if( tree->typeFailed[expr] ) {
+		*typeFlag = true;
+	}
+	return tree->type[expr];
+}
+
+Type *CheckPass::ComputeType(Row expr, bool *typeFlag) {
+	switch( tree->Kind(expr) ) {
+	  case NK_IntConstant:     return Type::intType;
+	  case NK_FloatConstant:   return Type::floatType;
+	  case NK_BoolConstant:    return Type::boolType;
+	  case NK_VarExpr:         return VarExprType(expr, typeFlag);
+	  case NK_ArithmeticExpr:
+	  case NK_RelationalExpr:
+	  case NK_EqualityExpr:
+	  case NK_LogicalExpr:
+	  case NK_AssignExpr:
+	  case NK_PostfixExpr:     return CompoundExprType(expr, typeFlag);
+	  case NK_ConditionalExpr: return ConditionalExprType(expr, typeFlag);
+	  case NK_ArrayAccess:     return ArrayAccessType(expr, typeFlag);
+	  case NK_FieldAccess:     return FieldAccessType(expr, typeFlag);
+	  case NK_Call:            return CallType(expr, typeFlag);
+	  default:                 return Type::errorType;
+	}
+}
+
+/* Every operator expression is typed by the operator table (optypes.h).
+ * When the operands don't fit the operator, the error is reported unless
+ * one has been already, and the expression takes the type it would most
+ * likely have had: bool for a comparison, else the type of the left (or
+ * only) operand.
+ */
+Type *CheckPass::CompoundExprType(Row expr, bool *typeError){
+	Row left = tree->Child(expr, 0), op = tree->Child(expr, 1), right = tree->Child(expr, 2);
+	OpCode code = tree->value[op].op;
+
+	if(left != FlatTree::None && right != FlatTree::None){
+		Type* ltype = GetType(left, typeError);
+		Type* rtype = GetType(right, typeError);
+		Type* result = BinaryResultType(code, ltype, rtype);
+
+		if( result == NULL ) {
+			if(*typeError == false)
+				ReportError::IncompatibleOperands(tree, op, ltype, rtype);
+			*typeError = true;
+			return IsComparisonOrLogical(code) ? Type::boolType : ltype;
+		}
+		return result;
+	}
+
+	Type* operand = GetType(left != FlatTree::None ? left : right, typeError);
+	Type* result = UnaryResultType(code, operand);
+	if( result == NULL ) {
+		if(*typeError == false)
+			ReportError::IncompatibleOperand(tree, op, operand);
+		*typeError = true;
+		return operand;
+	}
+	return result;
+}
+
+Type *CheckPass::VarExprType(Row expr, bool *typeError){
+	Row decl = tree->decl[expr];
+	if(decl == FlatTree::None){
+		if(*typeError == false)
+			ReportError::IdentifierNotDeclared(tree, tree->Child(expr, 0), LookingForVariable);
+		*typeError = true;
+		return Type::errorType;
+	}
+
+	if( tree->Kind(decl) == NK_VarDecl )
+		return tree->value[tree->Child(decl, 1)].type;
+	else
+		return Type::errorType;
+}
+
+Type *CheckPass::ConditionalExprType(Row expr, bool *typeError){
+	Type* condType = GetType(tree->Child(expr, 0), typeError);
+	Type* trueType = GetType(tree->Child(expr, 1), typeError);
+	Type* falseType = GetType(tree->Child(expr, 2), typeError);
+
+	/** not tested so return whatever is fine **/
+	return trueType;
+}
+
+Type *CheckPass::ArrayAccessType(Row expr, bool *typeError){
+	Row base = tree->Child(expr, 0);
+	Type* baseType = GetType(base, typeError);
+
+	if( baseType->GetKind() != TK_Array ){
+		if( tree->Kind(base) == NK_VarExpr ){
+			if( *typeError == false )
+				ReportError::NotAnArray(tree, tree->Child(base, 0));
+			*typeError = true;
+		}
+		return Type::errorType;
+	}
+
+	return cast<ArrayType>(baseType->GetCanonical())->GetElemType();
+}
+
+Type *CheckPass::CallType(Row call, bool *typeError){
+  Row decl = tree->decl[call];
+  Row field = tree->Child(call, 1);
+  if(decl != FlatTree::None) {
+    /*** Check if it's a function ***/
+    if( tree->Kind(decl) != NK_FnDecl ) {
+      ReportError::NotAFunction(tree, field);
+      *typeError = true;
+      return Type::errorType;
+    }
+
+
+    /*** Checking # of arguments ****/
+    // less the return type, name and body; less the base and name
+    int expCount = tree->NumChildren(decl) - 3;
+    int actualCount = tree->NumChildren(call) - 2;
+    if( expCount < actualCount ) {
+      if(*typeError == false)
+        ReportError::ExtraFormals(tree, field, expCount, actualCount);
+      *typeError = true;
+    } else if ( expCount  > actualCount ) {
+      if(*typeError == false)
+        ReportError::LessFormals(tree, field, expCount, actualCount);
+      *typeError = true;
+    }
+
+    return tree->value[tree->Child(decl, 0)].type;
+  }
+
+  return Type::errorType;
+
+}
+
+Type *CheckPass::SwizzleType(int swizLen, bool *typeFlag, Row field, Row base){
+	switch(swizLen){
+		case 1:
+			return Type::floatType;
+			break;
+		case 2:
+			return Type::vec2Type;
+			break;
+		case 3:
+			return Type::vec3Type;
+			break;
+		case 4:
+			return Type::vec4Type;
+			break;
+		default:
+			if(*typeFlag == false)
+				ReportError::OversizedVector(tree, field, base);
+			*typeFlag = true;
+			return Type::errorType;
+			break;
+	}
+}
+
+Type *CheckPass::FieldAccessType(Row expr, bool *typeError){
+	Type* ltype;
+	Row base = tree->Child(expr, 0), field = tree->Child(expr, 1);
+	if(base != FlatTree::None){
+		ltype = GetType(base, typeError);
+		const char *swizzle = tree->value[field].name;
+		int swizLen = strlen(swizzle);
+
+		// 2 = vec2, 3 = vec3, 4 = vec4
+		int vNum = 0;
+		//check for invalid swizzles
+		for(int i=0;i<swizLen;i++){
+			switch(swizzle[i]){
+			case 'x':
+				vNum = vNum < 2 ? 2 : vNum;
+				break;
+			case 'y':
+				vNum = vNum < 2 ? 2 : vNum;
+				break;
+			case 'z':
+				vNum = vNum < 3 ? 3 : vNum;
+				break;
+			case 'w':
+				vNum = vNum < 4 ? 4 : vNum;
+				break;
+			default:
+				if(*typeError == false)
+					ReportError::InvalidSwizzle(tree, field, base);
+				*typeError = true;
+				return Type::errorType;
+				break;
+			}
+		}
+
+		//vec2
+		if(ltype->IsEquivalentTo(Type::vec2Type)){
+			if(vNum > 2 && *typeError == false){
+				ReportError::SwizzleOutOfBound(tree, field, base);
+				*typeError = true;
+				return Type::errorType;
+			}
+			return SwizzleType(swizLen, typeError, field, base);
+		}
+		//vec3
+		if(ltype->IsEquivalentTo(Type::vec3Type)){
+			if(vNum > 3 && *typeError == false){
+				ReportError::SwizzleOutOfBound(tree, field, base);
+				*typeError = true;
+				return Type::errorType;
+			}
+			return SwizzleType(swizLen, typeError, field, base);
+		}
+		//vec4
+		if(ltype->IsEquivalentTo(Type::vec4Type)){
+			if(vNum > 4 && *typeError == false){
+				ReportError::SwizzleOutOfBound(tree, field, base);
+				*typeError = true;
+				return Type::errorType;
+			}
+			return SwizzleType(swizLen, typeError, field, base);
+		}
+
+		if(*typeError == false)
+			ReportError::InaccessibleSwizzle(tree, field, base);
+		*typeError = true;
+		return Type::errorType;
+	}
+	return Type::errorType;
+}
@@ -0,0 +1,107 @@
+/* File: semantic.h
+ * ----------------
+ * The semantic analysis passes (see passes.h), which walk the flat form
+ * of the tree (see ast_flat.h) with a FlatVisitor. BindPass resolves
+ * names: it walks the tree opening and closing scopes as it goes, and
+ * records in the tree's decl column the declaration each VarExpr and
+ * Call refers to, and for each Decl the earlier declaration in the same
+ * scope it clashes with. Then CheckPass checks the declarations and
+ * statements, working out the types of expressions, and reports what is
+ * wrong; it never consults the symbol table, only what BindPass left in
+ * the tree. The type of each expression is kept in the tree's type
+ * column the first time it is needed, so asking again costs nothing.
+ *
+ * Neither allocates from the heap while it walks the tree, apart from
+ * composing the text of an error it reports: their state is a few plain
+ * members, and the symbol table keeps its storage from one program to
+ * the next (try -d allocstats).
+ *
+ * Once the names are bound, each top-level declaration can be checked
+ * on its own: nothing CheckPass learns about one is needed for another.
+ * Given a ThreadPool, CheckPass checks a whole Program's declarations on
+ * it at once, each with its own checker and its output captured, then
+ * writes their output out in source order, so it reads exactly as it
+ * would have had they been checked one after another.
+ */
+
+#ifndef _H_semantic
+#define _H_semantic
+
+#include "passes.h"
+#include "ast_visitor.h"
+#include "symtable.h"
+
+class ThreadPool;
+
+class BindPass : public Pass, public FlatVisitor<BindPass>
+{
+    SymbolTable symtable;
+
+  public:
+    const char *GetName() { return "bind"; }
+    void Begin() { symtable.Reset(); }
+    void Run(FlatTree *t, Row root) { tree = t; Visit(root); }
+
+    void VisitNode(Row n);
+    void VisitVarDecl(Row var);
+    void VisitFnDecl(Row fn);
+    void VisitStmtBlock(Row block);
+    void VisitVarExpr(Row expr);
+    void VisitCall(Row call);
+};
+
+class CheckPass : public Pass, public FlatVisitor<CheckPass>
+{
+    Type *returnType;   // of the function being checked, or NULL outside one
+    bool foundReturn;   // whether it has returned a value, if it must
+    int loops;          // how many loops we are inside of
+    int switchStmt;     // and switches
+    ThreadPool *pool;   // to check declarations on, or NULL
+
+    void CheckBlock(Row fn);
+    void CheckInParallel(Row program);
+
+          // The type of an expression, reporting any error in it unless
+          // *typeFlag is already set, and then setting it
+    Type *GetType(Row expr, bool *typeFlag);
+    Type *ComputeType(Row expr, bool *typeFlag);
+    Type *CompoundExprType(Row expr, bool *typeFlag);
+    Type *VarExprType(Row expr, bool *typeFlag);
+    Type *ConditionalExprType(Row expr, bool *typeFlag);
+    Type *ArrayAccessType(Row expr, bool *typeFlag);
+    Type *CallType(Row call, bool *typeFlag);
+    Type *FieldAccessType(Row expr, bool *typeFlag);
+    Type *SwizzleType(int swizLen, bool *typeFlag, Row field, Row base);
+
+  public:
+    CheckPass(ThreadPool *p = NULL)
+      : returnType(NULL), foundReturn(false), loops(0), switchStmt(0), pool(p) {}
+    const char *GetName() { return "check"; }
+    void Begin();
+    void Run(FlatTree *t, Row root) { tree = t; Visit(root); }
+
+    void VisitProgram(Row program);
+    void VisitVarDecl(Row var);
+    void VisitFnDecl(Row fn);
+    void VisitStmtBlock(Row block);
+    void VisitDeclStmt(Row stmt);
+    void VisitIfStmt(Row stmt);
+    void VisitWhileStmt(Row stmt);
+    void VisitForStmt(Row stmt);
+    void VisitBreakStmt(Row stmt);
+    void VisitContinueStmt(Row stmt);
+    void VisitReturnStmt(Row stmt);
+    void VisitSwitchStmt(Row stmt);
+    void VisitCase(Row label);
+    void VisitDefault(Row label);
+    void VisitExpr(Row expr);
+};
+
+/* Function: AddSemanticPasses()
+ * -----------------------------
+ * Adds the passes above, in the order they must run, to a PassManager,
+ * with the checks to be done on pool if there is one.
+ */
+void AddSemanticPasses(PassManager *passes, ThreadPool *pool = NULL);
+
+#endif
@@ -0,0 +1,217 @@
+/* File: source.cc
+ * ---------------
+ * Implementation of the memory-mapped source buffer.
+ */
+
+#include "source.h"
+#include "utility.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+SourceBuffer::SourceBuffer() {
+    text = NULL;
+    size = mappedSize = capacity = 0;
+}
+
+SourceBuffer::~SourceBuffer() {
+    Release();
+}
+
+/* The file is laid over the front of an anonymous private mapping that is
+ * two bytes longer than the file. Pages past end-of-file are anonymous and
+ * read back as zero, so the trailing NULs flex needs never touch the file,
+ * even when its size is an exact multiple of the page size. The mapping is
+ * private and writable because flex temporarily stores a NUL after each
+ * lexeme; those writes dirty only the pages they land on.
+ */
+bool SourceBuffer::MapFile(const char *path) {
+    Release();
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    size_t len = st.st_size;
+    if (len > UINT32_MAX) { // line table offsets are 32-bit
+        close(fd);
+        return false;
+    }
+    void *base = mmap(NULL, len + 2, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    if (len > 0 && mmap(base, len, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, len + 2);
+        close(fd);
+        return false;
+    }
+    close(fd);
+
+    text = (char *)base;
+    size = len;
+    mappedSize = len + 2;
+    IndexLines(0);
+    return true;
+}
+
+bool SourceBuffer::ReadStream(FILE *fp) {
+    Release();
+    long got;
+    while ((got = Fill(fileno(fp))) > 0)
+        ;
+    if (got < 0) {
+        Release();
+        return false;
+    }
+    return true;
+}
+
+bool SourceBuffer::Copy(const char *src, size_t len) {
+    if (len > UINT32_MAX) return false; // line table offsets are 32-bit
+    if (mappedSize || capacity < len + 2) {
+        Release();
+        text = (char *)malloc(len + 2);
+        if (!text) return false;
+        capacity = len + 2;
+    }
+    memcpy(text, src, len);
+    size = len;
+    text[size] = text[size+1] = '\0';
+    IndexLines(0);
+    return true;
+}
+
+/* The block always has room for the two trailing NULs, and is doubled
+ * whenever less than a chunk would be left free for the next read.
+ */
+long SourceBuffer::Fill(int fd) {
+    const size_t ChunkSize = 64 * 1024;
+    Assert(mappedSize == 0);
+    if (capacity - size < ChunkSize + 2) {
+        size_t newCapacity = (capacity ? capacity * 2 : ChunkSize + 2);
+        if (newCapacity > UINT32_MAX) return -1; // line table offsets are 32-bit
+        char *grown = (char *)realloc(text, newCapacity);
+        if (!grown) return -1;
+        text = grown;
+        capacity = newCapacity;
+    }
+
+    ssize_t got;
+    do {
+        got = read(fd, text + size, capacity - size - 2);
+    } while (got < 0 && errno == EINTR);
+    if (got < 0) return -1;
+
+    size_t from = size;
+    size += got;
+    text[size] = text[size+1] = '\0';
+    IndexLines(from);
+    return got;
+}
+
+void SourceBuffer::Release() {
+    if (text && mappedSize) munmap(text, mappedSize);
+    else free(text);
+    text = NULL;
+    size = mappedSize = capacity = 0;
+    lineStarts.clear();
+}
+
+/* Function: FindNewlines
+ * ----------------------
+ * Appends to starts the offset just past every newline in [from, size),
+ * leaving the scalar tail to the caller. The SSE2 version is always
+ * available on x86-64; the AVX2 one is picked at run time when the CPU
+ * has it, so the build does not need -mavx2.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+static size_t FindNewlinesSSE2(const char *text, size_t from, size_t size,
+                               vector<uint32_t> &starts) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    for (; from + 16 <= size; from += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(text + from));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, nl));
+        while (mask) {
+            starts.push_back(from + __builtin_ctz(mask) + 1);
+            mask &= mask - 1;
+        }
+    }
+    return from;
+}
+
+__attribute__((target("avx2")))
+static size_t FindNewlinesAVX2(const char *text, size_t from, size_t size,
+                               vector<uint32_t> &starts) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    for (; from + 32 <= size; from += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(text + from));
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, nl));
+        while (mask) {
+            starts.push_back(from + __builtin_ctz(mask) + 1);
+            mask &= mask - 1;
+        }
+    }
+    return from;
+}
+
+static size_t FindNewlines(const char *text, size_t from, size_t size,
+                           vector<uint32_t> &starts) {
+    static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+    return hasAVX2 ? FindNewlinesAVX2(text, from, size, starts)
+                   : FindNewlinesSSE2(text, from, size, starts);
+}
+#else
+static size_t FindNewlines(const char *text, size_t from, size_t size,
+                           vector<uint32_t> &starts) {
+    return from;
+}
+#endif
+
+/* Records where each line begins, for the text from offset from onwards
+ * (which is where the previous call left off, if any). A newline that
+ * ends the text does not start another line unless more text follows,
+ * so NumLines() ignores a last entry that points at the end.
+ */
+void SourceBuffer::IndexLines(size_t from) {
+    if (from == 0) {
+        lineStarts.clear();
+        if (size == 0) return;
+        lineStarts.reserve(size / 32 + 1); // typical shader line length
+        lineStarts.push_back(0);
+    }
+    for (size_t i = FindNewlines(text, from, size, lineStarts); i < size; i++)
+        if (text[i] == '\n') lineStarts.push_back(i + 1);
+}
+
+int SourceBuffer::LineOf(uint32_t offset) const {
+    return upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin();
+}
+
+int SourceBuffer::NumLines() const {
+    if (lineStarts.empty()) return 0;
+    return lineStarts.size() - (lineStarts.back() == size ? 1 : 0);
+}
+
+const char *SourceBuffer::GetLine(int n, int *len) const {
+    if (n <= 0 || n > NumLines()) return NULL;
+    size_t start = lineStarts[n-1];
+    size_t stop = (n < NumLines() ? lineStarts[n] - 1 : size);
+    if (stop > start && text[stop-1] == '\n') stop--; // file ends in newline
+    *len = stop - start;
+    return text + start;
+}
@@ -0,0 +1,78 @@
+/* File: source.h
+ * --------------
+ * This file defines the SourceBuffer class which holds the text of the
+ * shader being compiled. A file named on the command line is mapped
+ * straight into memory rather than read through stdio, and stdin is
+ * slurped into one contiguous block, so the scanner can lex either in
+ * place and error reporting can point back into the buffer without
+ * keeping a second copy of every line. Text handed over by a program
+ * that embeds the compiler (see glc.h) is copied into a block that is
+ * kept for the next text, in the same way.
+ *
+ * Lines are located through a table of 32-bit line-start offsets built
+ * in a single vectorized pass over the text when it is loaded.
+ */
+
+#ifndef _H_source
+#define _H_source
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+using namespace std;
+
+class SourceBuffer
+{
+  protected:
+    char *text;                 // start of the mapping or heap block
+    size_t size;                // bytes of source text (excludes padding)
+    size_t mappedSize;          // bytes actually mapped, 0 if heap block
+    size_t capacity;            // bytes allocated for a heap block
+    vector<uint32_t> lineStarts; // offset of first char of each line
+
+    void IndexLines(size_t from);
+
+  public:
+    SourceBuffer();
+    ~SourceBuffer();
+
+          // Maps the named file privately into memory, followed by the two
+          // NUL bytes flex expects at the end of a scan buffer. Returns
+          // false if the file cannot be opened or mapped.
+    bool MapFile(const char *path);
+
+          // Reads the stream to end of file into one block padded the
+          // same way. Returns false on a read error.
+    bool ReadStream(FILE *fp);
+
+          // Copies len bytes of text into a heap block padded the same
+          // way, reusing the block from the last copy when it is big
+          // enough. Returns false if the block cannot be had.
+    bool Copy(const char *src, size_t len);
+
+          // Appends whatever the descriptor has ready, up to one chunk,
+          // to a heap block (which may move) and indexes the new lines.
+          // Returns the number of bytes added, 0 at end of file or -1 on
+          // a read error.
+    long Fill(int fd);
+    void Release();
+
+    char *GetText()             { return text; }
+    size_t GetSize() const      { return size; }
+    bool IsLoaded() const       { return text != NULL; }
+
+          // Returns the start of line n (1-based) and sets *len to its
+          // length, not counting the newline. The text is NOT terminated.
+          // Returns NULL if there is no such line.
+    const char *GetLine(int n, int *len) const;
+    int NumLines() const;
+
+          // Returns the number (1-based) of the line holding the given
+          // offset, found by binary search of the line table.
+    int LineOf(uint32_t offset) const;
+    uint32_t GetLineStart(int n) const { return lineStarts[n-1]; }
+};
+
+#endif
@@ -47,6 +47,31 @@ then
         cp parser.y $pid/
         cp symtable.cc $pid/
         cp symtable.h $pid/
+        cp source.cc $pid/
+        cp source.h $pid/
+        cp fastscan.cc $pid/
+        cp fastscan.h $pid/
+        cp intern.cc $pid/
+        cp intern.h $pid/
+        cp arena.cc $pid/
+        cp arena.h $pid/
+        cp optypes.cc $pid/
+        cp optypes.h $pid/
+        cp passes.cc $pid/
+        cp passes.h $pid/
+        cp semantic.cc $pid/
+        cp semantic.h $pid/
+        cp allocstats.cc $pid/
+        cp allocstats.h $pid/
+        cp threadpool.cc $pid/
+        cp threadpool.h $pid/
+        cp compilation.cc $pid/
+        cp compilation.h $pid/
+        cp countednew.cc $pid/
+        cp glc.cc $pid/
+        cp glc.h $pid/
+        cp symbench.cc $pid/
+        cp pooltest.cc $pid/
 
 	zip -r $pid.zip $pid/*
 else 
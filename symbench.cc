@@ -0,0 +1,135 @@
+/* File: symbench.cc
+ * -----------------
+ * A benchmark of the two symbol tables in symtable.h on scopes far
+ * bigger than a shader's, built with "make symbench". For each number of
+ * global names it times, per operation:
+ *
+ *    insert    binding every global name in one scope
+ *    find      looking each of them up again
+ *    function  a function's worth of work inside the globals: opening a
+ *              scope, binding a few locals, a mix of lookups that hit
+ *              locals, hit globals and miss, and closing the scope
+ *    snapshot  taking a snapshot of the globals and looking a name up in
+ *              it (persistent only)
+ *
+ * Usage: symbench [<number of globals> ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "symtable.h"
+#include "intern.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static const int Locals = 16;       // declared in each function
+static const int Lookups = 64;      // made in each function
+static const int Functions = 20000;
+
+struct Timings {
+    double insert, find, function, snapshot;   // nanoseconds per operation
+};
+
+static double Nanoseconds(Clock::time_point start, long ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+}
+
+/* Names come interned, as the scanner hands them over. */
+static std::vector<const char *> MakeNames(const char *prefix, int n) {
+    std::vector<const char *> names;
+    for (int i = 0; i < n; i++)
+        names.push_back(Intern((prefix + std::to_string(i)).c_str()));
+    return names;
+}
+
+/* Takes snapshots and looks a name up in each; the hashed table can't. */
+static double Snapshots(SymbolTable *, const std::vector<const char *> &, int *) {
+    return 0;
+}
+
+static double Snapshots(PersistentSymbolTable *table,
+                        const std::vector<const char *> &globals, int *sink) {
+    Clock::time_point start = Clock::now();
+    for (int f = 0; f < Functions; f++) {
+        SymbolSnapshot snapshot = table->Snapshot();
+        *sink += snapshot.find(globals[f % globals.size()]) != NULL;
+    }
+    return Nanoseconds(start, Functions);
+}
+
+template<class Table> static Timings Run(Table *table, const std::vector<const char *> &globals,
+                                         const std::vector<const char *> &locals,
+                                         const std::vector<const char *> &missing)
+{
+    Timings t = { 0, 0, 0, 0 };
+    int n = globals.size();
+    int sink = 0;
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < n; i++) {
+        Symbol s(globals[i], i, E_VarDecl);
+        table->insert(s);
+    }
+    t.insert = Nanoseconds(start, n);
+
+    start = Clock::now();
+    for (int i = 0; i < n; i++)
+        sink += table->find(globals[i]) != NULL;
+    t.find = Nanoseconds(start, n);
+
+    unsigned pick = 12345;
+    start = Clock::now();
+    for (int f = 0; f < Functions; f++) {
+        table->push();
+        for (int i = 0; i < Locals; i++) {
+            Symbol s(locals[i], i, E_VarDecl);
+            table->insert(s);
+        }
+        for (int i = 0; i < Lookups; i++) {
+            pick = pick * 1103515245 + 12345;
+            const char *name = (i % 4 == 3 ? missing[pick % missing.size()]
+                                : i % 2 ? locals[pick % Locals] : globals[pick % n]);
+            sink += table->find(name) != NULL;
+        }
+        table->pop();
+    }
+    t.function = Nanoseconds(start, Functions);
+
+    t.snapshot = Snapshots(table, globals, &sink);
+    if (sink == 42) printf(" "); // keep the lookups from being optimized away
+    return t;
+}
+
+static void Print(const char *name, int n, const Timings &t, bool snapshots) {
+    printf("%-12s %9d %10.1f %10.1f %10.1f", name, n, t.insert, t.find, t.function);
+    if (snapshots)
+        printf(" %10.1f", t.snapshot);
+    printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<int> sizes;
+    for (int i = 1; i < argc; i++)
+        sizes.push_back(atoi(argv[i]));
+    if (sizes.empty())
+        sizes = { 100, 10000, 1000000 };
+
+    std::vector<const char *> locals = MakeNames("local", Locals);
+    std::vector<const char *> missing = MakeNames("missing", 1024);
+
+    printf("%-12s %9s %10s %10s %10s %10s\n", "table", "globals",
+           "insert", "find", "function", "snapshot");
+    printf("%-12s %9s %10s %10s %10s %10s\n", "", "", "(ns)", "(ns)", "(ns)", "(ns)");
+    for (size_t i = 0; i < sizes.size(); i++) {
+        std::vector<const char *> globals = MakeNames("global", sizes[i]);
+        SymbolTable hashed;
+        Print("hashed", sizes[i], Run(&hashed, globals, locals, missing), false);
+        PersistentSymbolTable persistent;
+        Print("persistent", sizes[i], Run(&persistent, globals, locals, missing), true);
+    }
+    return 0;
+}
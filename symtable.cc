@@ -3,77 +3,356 @@
  *
  */
 #include "symtable.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
 
+static const int InitialSlots = 64;	// a power of two
+static const int InitialScopes = 16;
+
+/** Sized up front for a typical shader, so binding one needn't allocate */
 SymbolTable::SymbolTable(){
-	tables.push_back(new ScopedTable());
+	slots.assign(InitialSlots, Slot());
+	bindings.reserve(InitialSlots * 2 / 3);
+	scopeStarts.reserve(InitialScopes);
+	slotsUsed = 0;
+	scopeStarts.push_back(0);
+}
 
+/** Back to a single empty global scope. The arrays keep their capacity,
+ *  so after the first few compilations checking allocates nothing. */
+void SymbolTable::Reset(){
+	bindings.clear();
+	scopeStarts.assign(1, 0);
+	std::fill(slots.begin(), slots.end(), Slot());
+	slotsUsed = 0;
 }
 
-/** It pushes the current scope to the end of the vector */
+/** It opens a new scope inside the current one */
 void SymbolTable::push(){
-	tables.push_back(new ScopedTable());
+	scopeStarts.push_back(bindings.size());
 }
 
-/** It removes the current scope from the vector */
+/** It closes the current scope, taking its bindings off the end of the
+ *  array in reverse order and making whatever they shadowed visible again */
 void SymbolTable::pop(){
-	tables.pop_back();
+	int start = scopeStarts.back();
+	scopeStarts.pop_back();
+	for( int i = bindings.size()-1; i >= start; i-- ){
+		Slot *slot = Probe(bindings[i].sym.name);
+		if( slot->binding == i )	// else it was remove()d already
+			slot->binding = bindings[i].shadowed;
+	}
+	bindings.resize(start);
+}
+
+/** Finds the slot for name: the one holding it, or else the empty slot
+ *  where it would go. Interned names are spread by their address. */
+SymbolTable::Slot *SymbolTable::Probe(const char *name){
+	size_t mask = slots.size() - 1;
+	size_t i = ((uintptr_t)name >> 3) * 0x9E3779B97F4A7C15ull >> 32 & mask;
+	while( slots[i].name != NULL && slots[i].name != name )
+		i = (i + 1) & mask;
+	return &slots[i];
+}
+
+/** Doubles the slots once they are two thirds full. Slots are never
+ *  emptied (a name whose bindings are all gone just has binding -1), so
+ *  there are no tombstones to worry about. */
+void SymbolTable::Grow(){
+	std::vector<Slot> old;
+	old.swap(slots);
+	slots.assign(old.size() * 2, Slot());
+	for( size_t i = 0; i < old.size(); i++ )
+		if( old[i].name != NULL )
+			*Probe(old[i].name) = old[i];
 }
 
-/** It should get the current scoped table and call insert method on that.
- *  It should throw an error when there is a declaration conflict while inserting
- *  returns 0 when symbol inserted without duplicates
- *  returns 1 when symbol inserted was a duplicate but replaced*/
-int SymbolTable::insert(Symbol &sym, bool *error){
-	
+/** It inserts into the current scope.
+ *  returns None when symbol inserted without duplicates
+ *  returns the earlier declaration when symbol inserted was a duplicate
+ *  but replaced it; reporting that is up to the caller */
+FlatTree::Index SymbolTable::insert(Symbol &sym){
+	Slot *slot = Probe(sym.name);
+	if( slot->name == NULL ) {
+		if( 3 * (slotsUsed + 1) > 2 * (int)slots.size() ) {
+			Grow();
+			slot = Probe(sym.name);
+		}
+		slot->name = sym.name;
+		slot->binding = -1;
+		slotsUsed++;
+	}
+
 	// redeclaration case
-	if( tables.back()->find(sym.name) != NULL ) {
-		Symbol *oldDecl = tables.back()->find(sym.name);
-		tables.back()->remove(*oldDecl);
-		if(*error == false)
-			ReportError::DeclConflict(sym.decl,oldDecl->decl);
-		*error = true;
-		tables.back()->insert(sym);
-		return 1;
+	if( slot->binding >= scopeStarts.back() ) {
+		Binding &old = bindings[slot->binding];
+		FlatTree::Index conflict = old.sym.decl;
+		old.sym = sym;
+		return conflict;
 	}
-	// back returns the last/most current scope table
-	tables.back()->insert(sym);
-	return 0;
+
+	Binding b = { sym, slot->binding };
+	slot->binding = bindings.size();
+	bindings.push_back(b);
+	return FlatTree::None;
 }
 
+/** It removes the symbol's binding from the current scope, if it has one */
 void SymbolTable::remove(Symbol &sym){
-	tables.back()->remove(sym);
-
+	Slot *slot = Probe(sym.name);
+	if( slot->name != NULL && slot->binding >= scopeStarts.back() )
+		slot->binding = bindings[slot->binding].shadowed;
 }
+
 /** It should return null if name is not found, return symbol otherwise */
 Symbol* SymbolTable::find(const char *name){
-	for( int i = tables.size()-1; i >= 0 ; i--){
-		ScopedTable* sp = tables[i];
-		Symbol* sym = sp->find(name);
-		if( sym != NULL )
-			return sym;
+	Slot *slot = Probe(name);
+	if( slot->name == NULL || slot->binding < 0 )
+		return NULL;
+	return &bindings[slot->binding].sym;
+}
+
+
+/*
+ * Persistent symbol table
+ *
+ */
+
+/** A name bound in some scope. Never changed once made: replacing it
+ *  makes a new one that shadows the same binding it did */
+struct ScopeBinding {
+	Symbol sym;
+	int depth;			// scope it was made in, outermost 0
+	const ScopeBinding *shadowed;	// of the same name further out, or NULL
+};
+
+/** One level of the trie, 32 ways wide, holding only the entries that
+ *  are present, in index order. An entry is a binding (its bit set in
+ *  leaves as well as children) or the node for the next level */
+struct ScopeTrieNode {
+	uint32_t children;
+	uint32_t leaves;
+	const void *entry[1];		// really one per bit set in children
+};
+
+static const int LevelBits = 5;
+
+/** Multiplying by an odd constant is one to one, so different names
+ *  always have different hashes; every bit of it is used by the
+ *  thirteenth level down, and two names can't share a path further */
+static uint64_t NameHash(const char *name){
+	return (uintptr_t)name * 0x9E3779B97F4A7C15ull;
+}
+
+static unsigned Index(uint64_t hash, int shift){
+	return hash << shift >> (64 - LevelBits);
+}
+
+static int Position(const ScopeTrieNode *n, uint32_t bit){
+	return __builtin_popcount(n->children & (bit - 1));
+}
+
+static ScopeTrieNode *NewNode(Arena *arena, int entries){
+	size_t size = offsetof(ScopeTrieNode, entry) + entries * sizeof(void *);
+	return (ScopeTrieNode *)arena->Allocate(size);
+}
+
+/** A copy of n with one entry more (at pos, for bit), one fewer, or the
+ *  same number; the entry at pos is left for the caller to fill in */
+static ScopeTrieNode *CopyNode(Arena *arena, const ScopeTrieNode *n,
+				int pos, int change, uint32_t bit){
+	int count = __builtin_popcount(n->children);
+	ScopeTrieNode *c = NewNode(arena, count + change);
+	c->children = n->children;
+	c->leaves = n->leaves;
+	if( change > 0 ) c->children |= bit;
+	if( change < 0 ) { c->children &= ~bit; c->leaves &= ~bit; }
+	int skip = (change < 0 ? 1 : 0);
+	int gap = (change > 0 ? 1 : 0);
+	for( int i = 0; i < pos; i++ )
+		c->entry[i] = n->entry[i];
+	for( int i = pos + skip; i < count; i++ )
+		c->entry[i - skip + gap] = n->entry[i];
+	return c;
+}
+
+static const ScopeBinding *Lookup(const ScopeTrieNode *n, const char *name){
+	uint64_t hash = NameHash(name);
+	for( int shift = 0; n != NULL; shift += LevelBits ){
+		uint32_t bit = 1u << Index(hash, shift);
+		if( !(n->children & bit) )
+			return NULL;
+		const void *e = n->entry[Position(n, bit)];
+		if( n->leaves & bit ){
+			const ScopeBinding *b = (const ScopeBinding *)e;
+			return b->sym.name == name ? b : NULL;
+		}
+		n = (const ScopeTrieNode *)e;
 	}
 	return NULL;
 }
 
+/** The smallest subtree holding two bindings whose hashes agree on the
+ *  levels above shift */
+static const ScopeTrieNode *Pair(Arena *arena, const ScopeBinding *a,
+				const ScopeBinding *b, int shift){
+	unsigned ia = Index(NameHash(a->sym.name), shift);
+	unsigned ib = Index(NameHash(b->sym.name), shift);
+	if( ia == ib ){
+		ScopeTrieNode *n = NewNode(arena, 1);
+		n->children = 1u << ia;
+		n->leaves = 0;
+		n->entry[0] = Pair(arena, a, b, shift + LevelBits);
+		return n;
+	}
+	ScopeTrieNode *n = NewNode(arena, 2);
+	n->children = (1u << ia) | (1u << ib);
+	n->leaves = n->children;
+	n->entry[ia < ib ? 0 : 1] = a;
+	n->entry[ia < ib ? 1 : 0] = b;
+	return n;
+}
+
+/** n with b as the binding of its name, n itself untouched */
+static const ScopeTrieNode *Assoc(Arena *arena, const ScopeTrieNode *n,
+				const ScopeBinding *b, uint64_t hash, int shift){
+	uint32_t bit = 1u << Index(hash, shift);
+	if( n == NULL ){
+		ScopeTrieNode *c = NewNode(arena, 1);
+		c->children = c->leaves = bit;
+		c->entry[0] = b;
+		return c;
+	}
+	int pos = Position(n, bit);
+	if( !(n->children & bit) ){
+		ScopeTrieNode *c = CopyNode(arena, n, pos, 1, bit);
+		c->leaves |= bit;
+		c->entry[pos] = b;
+		return c;
+	}
+	ScopeTrieNode *c = CopyNode(arena, n, pos, 0, bit);
+	if( n->leaves & bit ){
+		const ScopeBinding *old = (const ScopeBinding *)n->entry[pos];
+		if( old->sym.name == b->sym.name )
+			c->entry[pos] = b;
+		else {
+			c->entry[pos] = Pair(arena, old, b, shift + LevelBits);
+			c->leaves &= ~bit;
+		}
+	} else
+		c->entry[pos] = Assoc(arena, (const ScopeTrieNode *)n->entry[pos],
+				      b, hash, shift + LevelBits);
+	return c;
+}
 
+/** n without a binding for name, or NULL if that leaves it empty. A node
+ *  left with a single binding isn't folded into its parent; lookups go
+ *  one level further than they need to, and that is all */
+static const ScopeTrieNode *Dissoc(Arena *arena, const ScopeTrieNode *n,
+				const char *name, uint64_t hash, int shift){
+	uint32_t bit = 1u << Index(hash, shift);
+	if( !(n->children & bit) )
+		return n;
+	int pos = Position(n, bit);
+	const ScopeTrieNode *sub = NULL;
+	if( n->leaves & bit ){
+		if( ((const ScopeBinding *)n->entry[pos])->sym.name != name )
+			return n;
+	} else {
+		const ScopeTrieNode *child = (const ScopeTrieNode *)n->entry[pos];
+		sub = Dissoc(arena, child, name, hash, shift + LevelBits);
+		if( sub == child )
+			return n;
+	}
+	if( sub != NULL ){
+		ScopeTrieNode *c = CopyNode(arena, n, pos, 0, bit);
+		c->entry[pos] = sub;
+		return c;
+	}
+	if( n->children == bit )
+		return NULL;
+	return CopyNode(arena, n, pos, -1, bit);
+}
 
-/*********************** SCOPED TABLE ****************************************/
-ScopedTable::ScopedTable(){
-	//symbols = new map<const char*, Symbol, lessStr>();
+const Symbol *SymbolSnapshot::find(const char *name) const {
+	const ScopeBinding *b = Lookup(root, name);
+	return b ? &b->sym : NULL;
 }
 
-void ScopedTable::insert(Symbol &sym){
-	symbols.insert(std::pair<const char*, Symbol>(sym.name, sym));
+PersistentSymbolTable::PersistentSymbolTable(){
+	base = root = NULL;
+	baseDepth = 0;
+	pinned = storage.GetMark();
 }
 
-void ScopedTable::remove(Symbol &sym){
-	symbols.erase(sym.name);
+/** The snapshot's scopes are all outside this table's, so what is bound
+ *  here shadows what is bound there rather than clashing with it */
+PersistentSymbolTable::PersistentSymbolTable(const SymbolSnapshot &outer){
+	base = root = outer.root;
+	baseDepth = outer.depth + 1;
+	pinned = storage.GetMark();
 }
 
-Symbol* ScopedTable::find(const char *name){
-	if(symbols.find(name) !=  symbols.end()){
-    		return &symbols.find(name)->second;
-	}
-	else return NULL;
+void PersistentSymbolTable::Reset(){
+	root = base;
+	saved.clear();
+	storage.Rewind();
+	pinned = storage.GetMark();
 }
 
+void PersistentSymbolTable::push(){
+	Scope s = { root, storage.GetMark() };
+	saved.push_back(s);
+}
+
+/** Nothing made since the scope opened is reachable from the root it goes
+ *  back to, so the storage can go too, except what a snapshot still uses */
+void PersistentSymbolTable::pop(){
+	Scope &s = saved.back();
+	root = s.root;
+	storage.RewindTo(s.mark.bytesUsed > pinned.bytesUsed ? s.mark : pinned);
+	saved.pop_back();
+}
+
+FlatTree::Index PersistentSymbolTable::insert(Symbol &sym){
+	const ScopeBinding *old = Lookup(root, sym.name);
+	ScopeBinding *b = (ScopeBinding *)storage.Allocate(sizeof(ScopeBinding));
+	b->sym = sym;
+	b->depth = Depth();
+
+	// redeclaration case
+	FlatTree::Index conflict = FlatTree::None;
+	if( old != NULL && old->depth == b->depth ){
+		conflict = old->sym.decl;
+		b->shadowed = old->shadowed;
+	} else
+		b->shadowed = old;
+
+	root = Assoc(&storage, root, b, NameHash(sym.name), 0);
+	return conflict;
+}
+
+void PersistentSymbolTable::remove(Symbol &sym){
+	const ScopeBinding *b = Lookup(root, sym.name);
+	if( b == NULL || b->depth != Depth() )
+		return;
+	uint64_t hash = NameHash(sym.name);
+	if( b->shadowed != NULL )
+		root = Assoc(&storage, root, b->shadowed, hash, 0);
+	else
+		root = Dissoc(&storage, root, sym.name, hash, 0);
+}
+
+const Symbol *PersistentSymbolTable::find(const char *name) const {
+	const ScopeBinding *b = Lookup(root, name);
+	return b ? &b->sym : NULL;
+}
+
+SymbolSnapshot PersistentSymbolTable::Snapshot() const {
+	pinned = storage.GetMark();
+	SymbolSnapshot s;
+	s.root = root;
+	s.depth = Depth();
+	return s;
+}
@@ -1,27 +1,36 @@
 /**
  * File: symtable.h
  * ----------- 
- *  This file defines a class for symbol table and scoped table table.
+ *  This file defines a class for symbol table.
  *
- *  Scoped table is to hold all declarations in a nested scope. It simply
- *  uses the standard C++ map.
+ *  There is one hash table for all the scopes, open addressing keyed by
+ *  the interned name pointer, so probes compare addresses rather than
+ *  characters. Each slot points at the innermost binding of its name,
+ *  and each binding at the one it shadows, so a lookup costs the same
+ *  however deeply the scopes are nested. The bindings of the open scopes
+ *  are kept in order in one array, which doubles as the undo log: popping
+ *  a scope walks its bindings back, putting each shadowed binding back in
+ *  its slot.
  *
- *  Symbol table is implemented as a vector, where each vector entry holds
- *  a pointer to the scoped table.
+ *  A Symbol* returned by find() stays good only until the next insert().
+ *
+ *  PersistentSymbolTable below does the same job with a map that is never
+ *  changed in place, so that any state of it can be kept and searched
+ *  later (see there). Running symbench compares the two.
  */
 
 #ifndef _H_symtable
 #define _H_symtable
 
-#include <map>
 #include <vector>
 #include <iostream>
 #include <string.h>
 #include "errors.h"
+#include "arena.h"
+#include "ast_flat.h"
 
 using namespace std;
 
-class Decl;
 class Stmt;
 
 enum EntryKind {
@@ -30,54 +39,127 @@ enum EntryKind {
 };
 
 struct Symbol {
-  char *name;
-  Decl *decl;
+  const char *name;   // interned
+  FlatTree::Index decl; // the declaration's row (see ast_flat.h)
   EntryKind kind;
   int someInfo;
 
-  Symbol() : name(NULL), decl(NULL), kind(E_VarDecl), someInfo(0) {}
-  Symbol(char *n, Decl *d, EntryKind k, int info = 0) :
+  Symbol() : name(NULL), decl(FlatTree::None), kind(E_VarDecl), someInfo(0) {}
+  Symbol(const char *n, FlatTree::Index d, EntryKind k, int info = 0) :
         name(n),
         decl(d),
         kind(k),
         someInfo(info) {}
 };
 
-struct lessStr {
-  bool operator()(const char* s1, const char* s2) const
-  { return strcmp(s1, s2) < 0; }
-};
- 
-typedef map<const char *, Symbol, lessStr>::iterator SymbolIterator;
-
-class ScopedTable {
-  
+class SymbolTable {
+    struct Binding {
+      Symbol sym;
+      int shadowed;     // binding of the same name in an outer scope, or -1
+    };
+    struct Slot {
+      const char *name; // NULL while the slot is empty
+      int binding;      // innermost live binding of name, or -1
+    };
+
+    std::vector<Binding> bindings;  // every live binding, innermost scope last
+    std::vector<int> scopeStarts;   // index in bindings where each scope begins
+    std::vector<Slot> slots;        // open addressing, size a power of two
+    int slotsUsed;
+
+    Slot *Probe(const char *name);
+    void Grow();
 
   public:
-    map<const char *, Symbol, lessStr> symbols; // make it private after testing
-    ScopedTable();
-    ~ScopedTable();
+    SymbolTable();
+
+          // Empties the table for the next compilation, keeping the storage
+    void Reset();
 
-    void insert(Symbol &sym); 
+    void push();
+    void pop();
+    size_t NumScopes() const { return scopeStarts.size(); }
+
+          // Returns the declaration sym replaces in the current scope,
+          // or None if there is none
+    FlatTree::Index insert(Symbol &sym);
     void remove(Symbol &sym);
     Symbol *find(const char *name);
+
+};    
+
+/**
+ *  PersistentSymbolTable
+ *  ---------------------
+ *  The same operations over an immutable hash array mapped trie, keyed
+ *  like the table above by the interned name's address. Nothing in the
+ *  trie changes once made: binding a name copies the path from the root
+ *  down to its leaf and shares all the rest. So push() just remembers
+ *  the current root and pop() goes back to it, and Snapshot() hands out
+ *  the bindings visible right now, which stay exactly as they are
+ *  whatever the table does afterwards. A snapshot can be searched from
+ *  any number of threads without locking, and a table can be started
+ *  inside one, the way a function's scopes sit inside the global scope.
+ *
+ *  Lookups take a few more steps than in SymbolTable, and every binding
+ *  copies a path. It all lives in the table's arena: pop() gives back
+ *  what the scope used unless a snapshot has been taken since it opened,
+ *  and Reset() gives back everything, ending the snapshots taken from the
+ *  table and any tables started inside those.
+ */
+
+struct ScopeTrieNode;
+struct ScopeBinding;
+
+class SymbolSnapshot {
+    const ScopeTrieNode *root;
+    int depth;              // number of scopes open when it was taken
+    friend class PersistentSymbolTable;
+
+  public:
+    SymbolSnapshot() : root(NULL), depth(0) {}
+    const Symbol *find(const char *name) const;
 };
-   
-class SymbolTable {
-   
+
+class PersistentSymbolTable {
+    Arena storage;
+    const ScopeTrieNode *base;  // the snapshot it was started in, if any
+    int baseDepth;
+    const ScopeTrieNode *root;
+    struct Scope {
+      const ScopeTrieNode *root;      // as it was when the scope opened
+      Arena::Mark mark;               // and the storage
+    };
+    std::vector<Scope> saved;
+    mutable Arena::Mark pinned;       // storage as of the latest snapshot
+
+    int Depth() const { return baseDepth + saved.size(); }
+
   public:
-    std::vector<ScopedTable *> tables;  //make it private after testing
-    SymbolTable();
-    ~SymbolTable();
+    PersistentSymbolTable();
+    explicit PersistentSymbolTable(const SymbolSnapshot &outer);
+
+          // Back to a single empty scope (inside the snapshot, if any),
+          // keeping the storage
+    void Reset();
 
     void push();
     void pop();
+    size_t NumScopes() const { return saved.size() + 1; }
 
-    int insert(Symbol &sym, bool *error);
+          // Returns the declaration sym replaces in the current scope,
+          // or None if there is none
+    FlatTree::Index insert(Symbol &sym);
     void remove(Symbol &sym);
-    Symbol *find(const char *name);
+    const Symbol *find(const char *name) const;
 
-};    
+          // The bindings visible now, good until Reset()
+    SymbolSnapshot Snapshot() const;
+
+  private:
+    PersistentSymbolTable(const PersistentSymbolTable &);
+    PersistentSymbolTable &operator=(const PersistentSymbolTable &);
+};
 
 class MyStack {
     vector<Stmt *> stmtStack;
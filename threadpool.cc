@@ -0,0 +1,112 @@
+/* File: threadpool.cc
+ * -------------------
+ * Implementation of the work-stealing thread pool.
+ */
+
+#include "threadpool.h"
+
+/* The pool and queue the calling thread works for, if it is a worker,
+ * so that tasks it submits go on its own queue.
+ */
+static thread_local ThreadPool *currentPool = NULL;
+static thread_local int currentQueue = -1;
+
+ThreadPool::ThreadPool(int numThreads) {
+    if (numThreads <= 0)
+        numThreads = std::thread::hardware_concurrency();
+    if (numThreads <= 0)
+        numThreads = 1;
+    nextQueue = 0;
+    queued = unfinished = 0;
+    stopping = false;
+    for (int i = 0; i < numThreads; i++)
+        queues.push_back(new Queue);
+    for (int i = 0; i < numThreads; i++)
+        workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool() {
+    Wait();
+    {
+        std::lock_guard<std::mutex> hold(stateLock);
+        stopping = true;
+    }
+    workReady.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    for (size_t i = 0; i < queues.size(); i++)
+        delete queues[i];
+}
+
+void ThreadPool::Submit(Task task) {
+    int q;
+    {
+        std::lock_guard<std::mutex> hold(stateLock);
+        unfinished++;
+        q = (currentPool == this ? currentQueue : nextQueue++ % queues.size());
+    }
+    {
+        std::lock_guard<std::mutex> hold(queues[q]->lock);
+        queues[q]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> hold(stateLock);
+        queued++;
+    }
+    workReady.notify_one();
+}
+
+void ThreadPool::Wait() {
+    std::unique_lock<std::mutex> hold(stateLock);
+    allDone.wait(hold, [this] { return unfinished == 0; });
+}
+
+/* Takes the oldest task from the worker's own queue, so that what it was
+ * dealt runs in the order it was submitted, or failing that the newest
+ * from the next queue round that has any, which its owner would have got
+ * to last.
+ */
+bool ThreadPool::TakeTask(int self, Task *task) {
+    int n = queues.size();
+    for (int i = 0; i < n; i++) {
+        Queue *q = queues[(self + i) % n];
+        std::lock_guard<std::mutex> hold(q->lock);
+        if (q->tasks.empty())
+            continue;
+        if (i == 0) {
+            *task = std::move(q->tasks.front());
+            q->tasks.pop_front();
+        } else {
+            *task = std::move(q->tasks.back());
+            q->tasks.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop(int self) {
+    currentPool = this;
+    currentQueue = self;
+    for (;;) {
+        Task task;
+        if (TakeTask(self, &task)) {
+            {
+                std::lock_guard<std::mutex> hold(stateLock);
+                queued--;
+            }
+            task();
+            task = nullptr;
+            std::lock_guard<std::mutex> hold(stateLock);
+            if (--unfinished == 0)
+                allDone.notify_all();
+            continue;
+        }
+        // A task can be in a queue a moment before it is counted, so
+        // this may go round again before finding it.
+        std::unique_lock<std::mutex> hold(stateLock);
+        workReady.wait(hold, [this] { return queued > 0 || stopping; });
+        if (stopping && queued <= 0)
+            return;
+    }
+}
@@ -0,0 +1,80 @@
+/* File: threadpool.h
+ * ------------------
+ * This file defines ThreadPool, a fixed set of worker threads that run
+ * tasks handed to them, for compiling many shaders in one process (see
+ * --batch in main.cc).
+ *
+ * Each worker has its own queue. Submit() deals tasks out to the queues
+ * in turn; a worker takes its next task from the front of its own queue,
+ * and once that is empty steals from the back of another's, so a worker
+ * that drew a run of cheap tasks helps out one stuck behind an expensive
+ * one instead of sitting idle. A task submitted from inside a task goes
+ * on the submitting worker's own queue.
+ *
+ * Taking the oldest task first means tasks start in about the order they
+ * were submitted (try "make pooltest"): with --batch, the files whose
+ * output is written first are compiled first, rather than the last ones
+ * named holding up the output of all the rest.
+ *
+ *    ThreadPool pool(0);          // one worker per core
+ *    for (...) pool.Submit([=] { ... });
+ *    pool.Wait();
+ *
+ * Tasks must not throw. Beyond that, the order in which tasks run is not
+ * defined; anything that has to come out in a particular order should be
+ * put in place by the tasks and written out afterwards.
+ */
+
+#ifndef _H_threadpool
+#define _H_threadpool
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+  public:
+    typedef std::function<void()> Task;
+
+          // Starts numThreads workers, or one per core if numThreads <= 0
+    explicit ThreadPool(int numThreads);
+
+          // Runs whatever is still queued, then stops the workers
+    ~ThreadPool();
+
+    void Submit(Task task);
+
+          // Waits until every task submitted so far has finished
+    void Wait();
+
+    int NumThreads() const { return workers.size(); }
+
+  private:
+    struct Queue {
+      std::mutex lock;
+      std::deque<Task> tasks;
+    };
+
+    std::vector<Queue *> queues;          // one per worker
+    std::vector<std::thread> workers;
+    unsigned nextQueue;                   // where Submit() puts the next task
+
+    std::mutex stateLock;                 // guards the fields below
+    std::condition_variable workReady;    // queued went up, or stopping
+    std::condition_variable allDone;      // unfinished went to 0
+    int queued;                           // tasks in the queues
+    int unfinished;                       // tasks submitted but not finished
+    bool stopping;
+
+    void WorkerLoop(int self);
+    bool TakeTask(int self, Task *task);
+
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+};
+
+#endif
@@ -10,7 +10,11 @@
 #include <vector>
 using std::vector;
 
-static vector<const char*> debugKeys;
+static DebugKeySet debugKeys;
+static thread_local const DebugKeySet *threadKeys = NULL;
+static vector<const char*> options;
+static vector<const char*> inputPaths;
+static thread_local OutputCapture *captured = NULL;
 static const int BufferSize = 2048;
 
 void Failure(const char *format, ...) {
@@ -25,24 +29,40 @@ void Failure(const char *format, ...) {
   abort();
 }
 
-int IndexOf(const char *key) {
-  for (unsigned int i = 0; i < debugKeys.size(); i++)
-    if (!strcmp(debugKeys[i], key)) 
-      return i;
+bool DebugKeySet::IsOn(const char *key) const {
+  for (unsigned int i = 0; i < keys.size(); i++)
+    if (keys[i] == key)
+      return true;
 
-  return -1;
+  return false;
+}
+
+void DebugKeySet::Set(const char *key, bool value) {
+  for (unsigned int i = 0; i < keys.size(); i++)
+    if (keys[i] == key) {
+      if (!value) keys.erase(keys.begin() + i);
+      return;
+    }
+  if (value)
+    keys.push_back(key);
+}
+
+const DebugKeySet &CommandLineDebugKeys() {
+  return debugKeys;
+}
+
+const DebugKeySet *UseDebugKeys(const DebugKeySet *keys) {
+  const DebugKeySet *saved = threadKeys;
+  threadKeys = keys;
+  return saved;
 }
 
 bool IsDebugOn(const char *key) {
-  return (IndexOf(key) != -1);
+  return (threadKeys ? threadKeys : &debugKeys)->IsOn(key);
 }
 
 void SetDebugForKey(const char *key, bool value) {
-  int k = IndexOf(key);
-  if (!value && k != -1)
-    debugKeys.erase(debugKeys.begin() + k);
-  else if (value && k == -1)
-    debugKeys.push_back(key);
+  debugKeys.Set(key, value);
 }
 
 void PrintDebug(const char *key, const char *format, ...) {
@@ -55,22 +75,119 @@ void PrintDebug(const char *key, const char *format, ...) {
   va_start(args, format);
   vsprintf(buf, format, args);
   va_end(args);
-  printf("+++ (%s): %s%s", key, buf, buf[strlen(buf)-1] != '\n'? "\n" : "");
+  fprintf(OutputFile(), "+++ (%s): %s%s", key, buf, buf[strlen(buf)-1] != '\n'? "\n" : "");
+}
+
+static void IncorrectUse(int argc, char *argv[]) {
+  printf("Incorrect Use:   ");
+  for (int i = 1; i < argc; i++) printf("%s ", argv[i]);
+  printf("\n");
+  printf("Correct Usage:   [<input-file>] [--scanner=fast|flex] [--stream] [--disable-pass=<name>] -d <debug-key-1> <debug-key-2> ... \n");
+  printf("                 --batch [--jobs=<n>] <file|directory|@list> ... [-d <debug-key-1> ...]\n");
+  exit(2);
 }
 
 void ParseCommandLine(int argc, char *argv[]) {
-  if (argc == 1)
+  int first = 1;
+  for (; first < argc && strcmp(argv[first], "-d") != 0; first++) {
+    if (strncmp(argv[first], "--", 2) == 0 && argv[first][2])
+      options.push_back(argv[first] + 2);
+    else if (argv[first][0] != '-')
+      inputPaths.push_back(argv[first]);
+    else
+      break;
+  }
+
+  if (inputPaths.size() > 1 && !GetOption("batch"))
+    IncorrectUse(argc, argv);
+
+  if (argc == first)
     return;
   
-  if (strcmp(argv[1], "-d") != 0) { // first arg is not -d
-    printf("Incorrect Use:   ");
-    for (int i = 1; i < argc; i++) printf("%s ", argv[i]);
-    printf("\n");
-    printf("Correct Usage:   -d <debug-key-1> <debug-key-2> ... \n");
-    exit(2);
-  }
+  if (strcmp(argv[first], "-d") != 0) // next arg is not -d
+    IncorrectUse(argc, argv);
 
-  for (int i = 2; i < argc; i++)
+  for (int i = first + 1; i < argc; i++)
     SetDebugForKey(argv[i], true);
 }
 
+const char *GetOption(const char *name) {
+  size_t len = strlen(name);
+  for (unsigned int i = 0; i < options.size(); i++)
+    if (!strncmp(options[i], name, len)) {
+      if (options[i][len] == '=') return options[i] + len + 1;
+      if (options[i][len] == '\0') return ""; // bare --name
+    }
+
+  return NULL;
+}
+
+const char *GetInputPath() {
+  return inputPaths.empty() ? NULL : inputPaths[0];
+}
+
+int NumInputPaths() {
+  return inputPaths.size();
+}
+
+const char *GetInputPath(int i) {
+  return inputPaths[i];
+}
+
+FILE *OutputFile() {
+  return captured ? captured->out : stdout;
+}
+
+FILE *ErrorFile() {
+  return captured ? captured->SwitchToErrors() : stderr;
+}
+
+OutputCapture::OutputCapture() {
+  outText = errText = NULL;
+  outSize = errSize = 0;
+  out = open_memstream(&outText, &outSize);
+  err = open_memstream(&errText, &errSize);
+  if (!out || !err) Failure("Unable to capture output");
+  saved = captured;
+  captured = this;
+}
+
+OutputCapture::~OutputCapture() {
+  Assert(captured != this);
+  free(outText);
+  free(errText);
+}
+
+void OutputCapture::Stop() {
+  Assert(captured == this);
+  captured = saved;
+  fclose(out);
+  fclose(err);
+  out = err = NULL;
+}
+
+FILE *OutputCapture::SwitchToErrors() {
+  fflush(out);
+  fflush(err);
+  switches.push_back(std::make_pair(outSize, errSize));
+  return err;
+}
+
+void OutputCapture::Replay() {
+  Assert(out == NULL);
+  FILE *to = OutputFile();
+  size_t outDone = (switches.empty() ? outSize : switches[0].first);
+  fwrite(outText, 1, outDone, to);
+  for (size_t i = 0; i < switches.size(); i++) {
+    size_t errTo = (i + 1 < switches.size() ? switches[i+1].second : errSize);
+    size_t outTo = (i + 1 < switches.size() ? switches[i+1].first : outSize);
+    if (errTo > switches[i].second) {
+      fflush(to);
+      FILE *errors = ErrorFile();
+      fwrite(errText + switches[i].second, 1, errTo - switches[i].second, errors);
+      fflush(errors);
+    }
+    fwrite(outText + outDone, 1, outTo - outDone, to);
+    outDone = outTo;
+  }
+}
@@ -9,6 +9,9 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string>
+#include <utility>
+#include <vector>
 
 /**
  * Function: Failure()
@@ -59,6 +62,7 @@ void PrintDebug(const char *key, const char *format, ...);
  * Turn on debugging messages for the given key.  See PrintDebug
  * for an example. Can be called manually when desired and will
  * be called from the provided main for flags passed with -d.
+ * Compilations already under way are not affected (see DebugKeySet).
  */
 
 void SetDebugForKey(const char *key, bool val);
@@ -73,14 +77,123 @@ void SetDebugForKey(const char *key, bool val);
 
 bool IsDebugOn(const char *key);
 
+/**
+ * Class: DebugKeySet
+ * ------------------
+ * The debugging keys that are on. SetDebugForKey() and the -d flags set
+ * the command line's; a compilation starts with a copy of those that it
+ * can change for itself (see compilation.h), and while one is under way
+ * on a thread, IsDebugOn() and PrintDebug() consult its set instead.
+ */
+
+class DebugKeySet
+{
+    std::vector<std::string> keys;
+
+  public:
+    bool IsOn(const char *key) const;
+    void Set(const char *key, bool value);
+};
+
+const DebugKeySet &CommandLineDebugKeys();
+
+      // Makes keys the set consulted on the calling thread (NULL for the
+      // command line's), returning the one it replaces
+const DebugKeySet *UseDebugKeys(const DebugKeySet *keys);
+
 /**
  * Function: ParseCommandLine
  * --------------------------
- * Turn on the debugging flags from the command line.  Verifies that
- * first argument is -d, and then interpret all the arguments that follow
- * as being flags to turn on.
+ * Turn on the debugging flags from the command line.  An optional input
+ * file (several, with --batch) and any --name=value options may come
+ * first; after those, verifies
+ * that the next argument is -d, and then interpret all the arguments that
+ * follow as being flags to turn on.
  */
 
 void ParseCommandLine(int argc, char *argv[]);
-     
+
+/**
+ * Function: GetOption
+ * Usage: if (GetOption("scanner")) ...
+ * ------------------------------------
+ * Returns the value given for --name=value on the command line, the empty
+ * string for a bare --name, or NULL if that option was not given. Options
+ * come before any -d flags.
+ */
+
+const char *GetOption(const char *name);
+
+/**
+ * Function: GetInputPath
+ * ----------------------
+ * Returns the input file named on the command line, or NULL if the
+ * source should be read from stdin. With --batch there can be more than
+ * one; they are numbered from 0 in the order given.
+ */
+
+const char *GetInputPath();
+int NumInputPaths();
+const char *GetInputPath(int i);
+
+/**
+ * Function: OutputFile(), ErrorFile()
+ * Usage: fprintf(OutputFile(), "VarDecl Check!\n");
+ * --------------------------------------------------
+ * Where the compiler writes what it has to say about the input: the
+ * check trace and debugging dumps go to OutputFile(), error messages to
+ * ErrorFile(). Ordinarily they are stdout and stderr, but while an
+ * OutputCapture is in effect on the calling thread they are its buffers,
+ * so the text of several compilations running at once doesn't mix.
+ * Fetch ErrorFile() afresh for each message and write the message before
+ * anything more goes to OutputFile(); that is how a capture keeps track
+ * of which came first.
+ */
+
+FILE *OutputFile();
+FILE *ErrorFile();
+
+/**
+ * Class: OutputCapture
+ * --------------------
+ * Collects everything the calling thread writes to OutputFile() and
+ * ErrorFile() from construction until Stop(), to be written out later,
+ * possibly from another thread, with Replay().
+ */
+
+class OutputCapture
+{
+    FILE *out, *err;
+    char *outText, *errText;
+    size_t outSize, errSize;
+    std::vector<std::pair<size_t, size_t> > switches; // to ErrorFile(), at
+                                                      // these sizes of both
+    OutputCapture *saved;
+
+  public:
+    OutputCapture();
+    ~OutputCapture();
+
+          // Puts back the output the thread had before. Must be called on
+          // the thread that made the capture, before it is destroyed.
+    void Stop();
+
+          // Writes what was captured to the calling thread's OutputFile()
+          // and ErrorFile(), interleaved as it was written
+    void Replay();
+
+          // What was captured from OutputFile() and ErrorFile(), once
+          // stopped
+    std::string GetOutput() const { return std::string(outText, outSize); }
+    std::string GetErrors() const { return std::string(errText, errSize); }
+
+  private:
+    friend FILE *OutputFile();
+    friend FILE *ErrorFile();
+    FILE *SwitchToErrors();
+
+    OutputCapture(const OutputCapture &);
+    OutputCapture &operator=(const OutputCapture &);
+};
+
 #endif